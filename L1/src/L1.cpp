@@ -7,7 +7,7 @@ namespace L1 {
 
     // Register, derived from Item
     Register::Register(const std::string &r)
-        : ID {r}{
+        : Item(ItemKind::reg), ID {r}{
         return ;
     }
     std::string Register::translate() {
@@ -18,7 +18,7 @@ namespace L1 {
     }
 
     Number::Number (int64_t n)
-        : value {n}{
+        : Item(ItemKind::number), value {n}{
         return ;
     }
     std::string Number::translate () {
@@ -29,7 +29,7 @@ namespace L1 {
     }
 
     Name::Name (const std::string &value)
-        : value {value}{
+        : Item(ItemKind::name), value {value}{
         return ;    
     }
     std::string Name::translate () {
@@ -41,7 +41,7 @@ namespace L1 {
     }
 
     Label::Label (const std::string &value)
-        : value {value}{
+        : Item(ItemKind::label), value {value}{
         return ;
     }
     std::string Label::translate () {
@@ -52,7 +52,7 @@ namespace L1 {
     }
 
     Operator::Operator (const std::string &sign)
-        : sign {sign} {
+        : Item(ItemKind::op), sign {sign} {
         return;
     }
     std::string Operator::translate() {
@@ -111,7 +111,7 @@ namespace L1 {
     Instruction class extensions
     */
 
-    Instruction_ret::Instruction_ret() {}
+    Instruction_ret::Instruction_ret() : Instruction(InstructionKind::ret) {}
     void Instruction_ret::printMe() {
         std::cout << "Instruction_ret:    return" << std::endl;
     }
@@ -119,7 +119,12 @@ namespace L1 {
     // Instruction_assignment Constructor
     // Instruction_assignment::Instruction_assignment(Item *dst, Item *src) : s(src), d(dst) {}
     Instruction_assignment::Instruction_assignment (Item *dst, Item *src)
-        : s { src },
+        : Instruction(InstructionKind::assignment), s { src },
+        d { dst } {
+        return ;
+    }
+    Instruction_assignment::Instruction_assignment (Item *dst, Item *src, InstructionKind kind)
+        : Instruction(kind), s { src },
         d { dst } {
         return ;
     }
@@ -138,13 +143,14 @@ namespace L1 {
     // at_instruction::at_instruction(Item *reg1, Item *reg2, Item *reg3, Integer *num) : reg1(reg1), reg2(reg2), reg3(reg3), num(num) {}
 
     // label_Instruction Constructor
-    label_Instruction::label_Instruction(Item *label) : label(label) {}
+    label_Instruction::label_Instruction(Item *label) : Instruction(InstructionKind::label), label(label) {}
+    label_Instruction::label_Instruction(Item *label, InstructionKind kind) : Instruction(kind), label(label) {}
     void label_Instruction::printMe() {
 
     }
 
     // goto_label_instruction Constructor
-    goto_label_instruction::goto_label_instruction(Item *label) : label_Instruction(label) {}
+    goto_label_instruction::goto_label_instruction(Item *label) : label_Instruction(label, InstructionKind::goto_label) {}
     void goto_label_instruction::printMe() {
 
     }
@@ -158,93 +164,93 @@ namespace L1 {
     // }
 
     // Call_tenserr_Instruction Constructor
-    Call_tenserr_Instruction::Call_tenserr_Instruction(Item *F) : F(F) {}
+    Call_tenserr_Instruction::Call_tenserr_Instruction(Item *F) : Instruction(InstructionKind::call_tenserr), F(F) {}
     void Call_tenserr_Instruction::printMe() {
 
     }
 
     // Call_uN_Instruction Constructor
-    Call_uN_Instruction::Call_uN_Instruction(Item *u, Item *N) : u(u), N(N) {}
+    Call_uN_Instruction::Call_uN_Instruction(Item *u, Item *N) : Instruction(InstructionKind::call_uN), u(u), N(N) {}
     void Call_uN_Instruction::printMe() {
 
     }
 
-    Memory_assignment_store::Memory_assignment_store(Item *dst, Item *s, Item *M) : dst(dst), s(s), M(M) {}
+    Memory_assignment_store::Memory_assignment_store(Item *dst, Item *s, Item *M) : Instruction(InstructionKind::memory_store), dst(dst), s(s), M(M) {}
     void Memory_assignment_store::printMe() {
         std::cout << "Memory_assignment_store:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", s = " << this->s->translate() << std::endl;
     }
 
-    Memory_assignment_load::Memory_assignment_load(Item *dst, Item *x, Item *M) : dst(dst), x(x), M(M) {}
+    Memory_assignment_load::Memory_assignment_load(Item *dst, Item *x, Item *M) : Instruction(InstructionKind::memory_load), dst(dst), x(x), M(M) {}
     void Memory_assignment_load::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", x = " << this->x->translate() << std::endl;
     }
 
     // Memory_arithmetic Constructor
     Memory_arithmetic_load::Memory_arithmetic_load(Item *dst, Item *x, Item *instruction, Item *M) 
-    : dst(dst), x(x), instruction(instruction), M(M) {}
+    : Instruction(InstructionKind::memory_arithmetic_load), dst(dst), x(x), instruction(instruction), M(M) {}
     void Memory_arithmetic_load::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", x = " << this->x->translate() << ", instruction = " << this->instruction->translate() << std::endl;
     }
 
     Memory_arithmetic_store::Memory_arithmetic_store(Item *dst, Item *t, Item *instruction, Item *M) 
-    : dst(dst), t(t), instruction(instruction), M(M) {}
+    : Instruction(InstructionKind::memory_arithmetic_store), dst(dst), t(t), instruction(instruction), M(M) {}
     void Memory_arithmetic_store::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", t = " << this->t->translate() << ", instruction = " << this->instruction->translate() << std::endl;
     }
     
     // cmp_Instruction Constructor
-    cmp_Instruction::cmp_Instruction(Item *dst, Item *t2, Item *method, Item *t1) : dst(dst), t1(t1), method(method), t2(t2) {}
+    cmp_Instruction::cmp_Instruction(Item *dst, Item *t2, Item *method, Item *t1) : Instruction(InstructionKind::cmp), dst(dst), t1(t1), method(method), t2(t2) {}
     void cmp_Instruction::printMe() {
 
     }
 
     // cjump_cmp_Instruction Constructor
-    cjump_cmp_Instruction::cjump_cmp_Instruction(Item *t2, Item *cmp, Item *t1, Item *label) : t2(t2), cmp(cmp), t1(t1), label(label) {}
+    cjump_cmp_Instruction::cjump_cmp_Instruction(Item *t2, Item *cmp, Item *t1, Item *label) : Instruction(InstructionKind::cjump), t2(t2), cmp(cmp), t1(t1), label(label) {}
     void cjump_cmp_Instruction::printMe() {
 
     }
 
     // AOP_assignment Constructor
-    AOP_assignment::AOP_assignment(Item *method, Item *dst, Item *src) : Instruction_assignment(dst, src), method(method) {}
+    AOP_assignment::AOP_assignment(Item *method, Item *dst, Item *src) : Instruction_assignment(dst, src, InstructionKind::aop), method(method) {}
     void AOP_assignment::printMe() {
         std::cout << "AOP_assignment:    " << "d = " << this->d->translate() << ", method = " << this->method->translate() << ", s = " << this->s->translate() << std::endl;
     }
 
     // SOP_assignment Constructor
-    SOP_assignment::SOP_assignment(Item *method, Item *dst, Item *src) : Instruction_assignment(dst, src), method(method) {}
+    SOP_assignment::SOP_assignment(Item *method, Item *dst, Item *src) : Instruction_assignment(dst, src, InstructionKind::sop), method(method) {}
     void SOP_assignment::printMe() {
         std::cout << "SOP_assignment:    " << "d = " << this->d->print() << ", method = " << this->method->print() << ", s = " << this->s->print() << std::endl;
     }
 
-    Call_print_Instruction::Call_print_Instruction() {}
+    Call_print_Instruction::Call_print_Instruction() : Instruction(InstructionKind::call_print) {}
     void Call_print_Instruction::printMe() {
 
     }
 
-    Call_input_Instruction::Call_input_Instruction() {}
+    Call_input_Instruction::Call_input_Instruction() : Instruction(InstructionKind::call_input) {}
     void Call_input_Instruction::printMe() {
 
     }
 
-    Call_allocate_Instruction::Call_allocate_Instruction() {}
+    Call_allocate_Instruction::Call_allocate_Instruction() : Instruction(InstructionKind::call_allocate) {}
     void Call_allocate_Instruction::printMe() {
 
     }
 
-    Call_tuple_Instruction::Call_tuple_Instruction() {}
+    Call_tuple_Instruction::Call_tuple_Instruction() : Instruction(InstructionKind::call_tuple) {}
     void Call_tuple_Instruction::printMe() {
 
     }
 
     w_increment_decrement::w_increment_decrement(Item *r, Item *symbol) 
-        : r(r), symbol(symbol) {
+        : Instruction(InstructionKind::increment_decrement), r(r), symbol(symbol) {
     }
     void w_increment_decrement::printMe() {
         std::cout << "w_increment_decrement:    " << "r = " << this->r->translate() << ", symbol = " << this->symbol->translate() << std::endl;
     }
 
     w_atreg_assignment::w_atreg_assignment(Item *r1, Item *r2, Item *r3, Item *E) 
-        : r1(r1), r2(r2), r3(r3), E(E) {
+        : Instruction(InstructionKind::atreg), r1(r1), r2(r2), r3(r3), E(E) {
     }
     void w_atreg_assignment::printMe() {
 
@@ -4,10 +4,11 @@
 #include <string>
 #include <variant>
 #include <iostream>
+#include <cstdint>
 
 namespace L1 {
 
-  extern const int debug;
+  extern int debug;
 
 
   // Forward declarations
@@ -34,8 +35,45 @@ namespace L1 {
   // };
   // using ItemValue = std::variant<int, std::string, RegisterID>; // Example using variant
 
+  /*
+  Kind tags, fixed when an Item or Instruction is built, so the code generator can switch on them instead of
+  trying one dynamic_cast after the other.
+  */
+  enum class ItemKind : uint8_t {
+    reg,
+    number,
+    name,
+    label,
+    op
+  };
+
+  enum class InstructionKind : uint8_t {
+    ret,
+    assignment,
+    label,
+    goto_label,
+    call_tenserr,
+    call_uN,
+    call_print,
+    call_input,
+    call_allocate,
+    call_tuple,
+    increment_decrement,
+    atreg,
+    memory_store,
+    memory_load,
+    memory_arithmetic_load,
+    memory_arithmetic_store,
+    cmp,
+    cjump,
+    aop,
+    sop
+  };
+
   class Item {
     public:
+      Item(ItemKind kind) : kind(kind) {}
+      const ItemKind kind;
 
       virtual std::string translate() = 0;    // returns string with the x86 conventions attached
       virtual std::string print() = 0;        // returns the value as is
@@ -139,6 +177,8 @@ namespace L1 {
    */
   class Instruction{
     public:
+      Instruction(InstructionKind kind) : kind(kind) {}
+      const InstructionKind kind;
       virtual void gen(Function *f, std::ofstream &outputFile) = 0;
       virtual void printMe() = 0;
   };
@@ -159,6 +199,7 @@ namespace L1 {
       void gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
     protected:
+      Instruction_assignment (Item *dst, Item *src, InstructionKind kind);
       Item *s;
       Item *d;
   };
@@ -184,6 +225,7 @@ namespace L1 {
       void printMe() override;
       // void gen(Function *f, std::ofstream &outputFile) override;
     protected:
+      label_Instruction(Item *label, InstructionKind kind);
       Item *label; 
   };
 
@@ -3,6 +3,7 @@
 #include <fstream>
 
 #include <code_generator.h>
+#include <libL1.h>
 #include "L1.h"
 
 using namespace std;
@@ -56,7 +57,7 @@ namespace L1{
   void Instruction_assignment::gen(Function *f, std::ofstream &outputFile) {
     if (debug) std::cerr << "gen method called for an Instruction_assignment instance!" << std::endl;
     outputFile << "movq ";
-    if (dynamic_cast<Name*>(this->s) || dynamic_cast<Label*>(this->s)) {
+    if (this->s->kind == ItemKind::name || this->s->kind == ItemKind::label) {
       outputFile << "$";
     }
     outputFile << this->s->translate() << ", " << this->d->translate() << "\n";
@@ -102,7 +103,7 @@ namespace L1{
     Number stack_space = Number(space);
     outputFile << "subq " << stack_space.translate() << ", %rsp\n";
     outputFile << "jmp ";
-    if (dynamic_cast<Register*>(this->u)) {
+    if (this->u->kind == ItemKind::reg) {
       outputFile << "*";
     }
     outputFile << this->u->translate() << "\n";
@@ -147,7 +148,7 @@ namespace L1{
       Changing the above line, it might be required that function namees in the source might also need to be 
       prepended by '$', and then the '_'
       */
-    if (dynamic_cast<Label*>(this->s) || dynamic_cast<Name*>(this->s)) {
+    if (this->s->kind == ItemKind::label || this->s->kind == ItemKind::name) {
       outputFile << "$";
     }
     outputFile << this->s->translate() << ", " << this->M->print() << "(" << this->dst->translate() << ")\n";
@@ -173,8 +174,8 @@ namespace L1{
     // also note - I don't 
     if (debug) std::cerr << "gen method called for a cmp_Instruction instance!" << std::endl;
     
-    if (dynamic_cast<Number*>(this->t2)) {
-      if (dynamic_cast<Number*>(this->t1)) {
+    if (this->t2->kind == ItemKind::number) {
+      if (this->t1->kind == ItemKind::number) {
         long long t1_val = std::stoll(this->t1->print());
         long long t2_val = std::stoll(this->t2->print());
         int64_t res = 0;
@@ -210,8 +211,8 @@ namespace L1{
     // cjump t2 cmp t1 label
     if (debug) std::cerr << "gen method called for a cjump_cmp_Instruction instance!" << std::endl;
 
-    if (dynamic_cast<Number*>(this->t2)) {
-      if (dynamic_cast<Number*>(this->t1)) {
+    if (this->t2->kind == ItemKind::number) {
+      if (this->t1->kind == ItemKind::number) {
         long long t1_val = std::stoll(this->t1->print());
         long long t2_val = std::stoll(this->t2->print());
         int64_t res = 0;
@@ -263,7 +264,7 @@ namespace L1{
   void SOP_assignment::gen(Function *f, std::ofstream &outputFile) {
     if (debug) std::cerr << "gen method called for a SOP_assignment instance!" << std::endl;
     outputFile << this->method->translate() << " ";
-    if (dynamic_cast< Register* >(this->s)) {
+    if (this->s->kind == ItemKind::reg) {
       outputFile << "%" << convert_reg(this->s->print());
     } else {
       outputFile << this->s->translate();
@@ -273,12 +274,16 @@ namespace L1{
 
 
   void generate_code(Program p){
+    generate_code(p, "prog.S");
+  }
+
+  void generate_code(Program &p, const std::string &fileName){
 
     /* 
      * Open the output file.
      */ 
     std::ofstream outputFile;
-    outputFile.open("prog.S");
+    outputFile.open(fileName);
    
     /* 
      * Generate target code
@@ -293,7 +298,7 @@ namespace L1{
     for (Function *fptr : p.functions) {
       std::string fname = fptr->name;
 
-      std::cout << "Currently generating for function " << fname << std::endl;
+      if (debug) std::cerr << "Currently generating for function " << fname << std::endl;
 
       outputFile << fname.replace(0, 1, "_") << ":\n";
       bool c = fptr->locals > 0;
@@ -302,7 +307,7 @@ namespace L1{
       }
 
       for (Instruction *iptr : fptr->instructions) {
-        std::cout << "Currently generating an instruction:" << std::endl;
+        if (debug) std::cerr << "Currently generating an instruction:" << std::endl;
         iptr->gen(fptr, outputFile);
       }
     }
@@ -12,13 +12,15 @@
 #include <unistd.h>
 #include <iostream>
 #include <assert.h>
+#include <chrono>
 
 #include <parser.h>
 #include <code_generator.h>
+#include <phase_timing.h>
 
 
 void print_help (char *progName){
-  std::cerr << "Usage: " << progName << " [-v] [-g 0|1] [-O 0|1|2] SOURCE" << std::endl;
+  std::cerr << "Usage: " << progName << " [-v] [-g 0|1] [-O 0|1|2] [-T table|json] SOURCE" << std::endl;
   return ;
 }
 
@@ -28,7 +30,9 @@ int main(
   ){
   auto enable_code_generator = true;
   int32_t optLevel = 0;
-  bool verbose;
+  bool verbose = false;
+  auto phase_report = false;
+  auto phase_report_json = false;
 
   /* 
    * Check the compiler arguments.
@@ -38,7 +42,7 @@ int main(
     return 1;
   }
   int32_t opt;
-  while ((opt = getopt(argc, argv, "vg:O:")) != -1) {
+  while ((opt = getopt(argc, argv, "vg:O:T:")) != -1) {
     switch (opt){
       case 'O':
         optLevel = strtoul(optarg, NULL, 0);
@@ -50,6 +54,12 @@ int main(
 
       case 'v':
         verbose = true;
+        L1::debug = 1;
+        break ;
+
+      case 'T':
+        phase_report = true;
+        phase_report_json = (strcmp(optarg, "json") == 0);
         break ;
 
       default:
@@ -58,10 +68,20 @@ int main(
     }
   }
 
+  /*
+   * -T: time the phases, otherwise the timers only test the flag.
+   */
+  L1::phase_timing = phase_report;
+  auto compilation_start = phase_report ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
   /*
    * Parse the input file.
    */
-  auto p = L1::parse_file(argv[optind]);
+  L1::Program p;
+  {
+    L1::PhaseScope parse_timer(L1::Phase::parse);
+    p = L1::parse_file(argv[optind]);
+  }
 
   /*
    * Code optimizations (optional)
@@ -85,8 +105,17 @@ int main(
    * Generate x86_64 assembly.
    */
   if (enable_code_generator){
+    L1::PhaseScope code_generation_timer(L1::Phase::code_generation);
     L1::generate_code(p);
   }
 
+  /*
+   * -T: where the compilation's time went, per phase, on stderr.
+   */
+  if (phase_report) {
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compilation_start).count();
+    L1::print_phase_report(std::cerr, phase_report_json, total_ms);
+  }
+
   return 0;
 }
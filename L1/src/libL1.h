@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+#include <L1.h>
+
+namespace L1{
+
+  /*
+  The L1 compiler as a library (make library, bin/libL1.a), for front ends that build their L1 program in memory
+  instead of writing an L1 file for bin/L1 to parse again; the L2 compiler lowers its allocated functions this way.
+  - the program is built with plain new out of the classes of L1.h, the library neither copies nor frees it.
+  - generate_code writes the x86_64 assembly of the program to fileName, exactly as bin/L1 writes prog.S, and
+    prints nothing else unless L1::debug is set.
+  */
+  void generate_code(Program &p, const std::string &fileName);
+
+}
@@ -40,7 +40,10 @@ using namespace std;
 
 namespace L1 {
 
-  const int debug = 1;
+  /*
+  Traces of the parser and the code generator; bin/L1 turns them on with -v, library users keep them off.
+  */
+  int debug = 0;
 
   /* 
    * Tokens parsed
@@ -0,0 +1,68 @@
+#include <malloc.h>
+#include <algorithm>
+#include <iomanip>
+
+#include "phase_timing.h"
+
+using namespace std;
+
+namespace L1 {
+
+    bool phase_timing = false;
+
+    static const char *phase_names[phase_count] = {
+      "parse",
+      "code generation"
+    };
+
+    static int64_t phase_ns[phase_count];
+    static int64_t phase_iterations[phase_count];
+    static int64_t phase_bytes[phase_count];
+
+    static int64_t heap_in_use() {
+      return (int64_t)mallinfo2().uordblks;
+    }
+
+    void PhaseScope::begin(Phase phase) {
+      this->phase = phase;
+      start_bytes = heap_in_use();
+      start = std::chrono::steady_clock::now();
+    }
+
+    void PhaseScope::end() {
+      int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+      int p = (int)phase;
+      phase_ns[p] += ns;
+      phase_iterations[p]++;
+      phase_bytes[p] += std::max<int64_t>(0, heap_in_use() - start_bytes);
+    }
+
+    void print_phase_report(std::ostream &out, bool json, double total_ms) {
+      if (json) {
+        out << "{\"compiler\": \"L1\", \"total_ms\": " << std::fixed << std::setprecision(3) << total_ms << ", \"phases\": [" << std::endl;
+        for (int p = 0; p < phase_count; p++) {
+          out << "{\"phase\": \"" << phase_names[p] << "\""
+              << ", \"ms\": " << phase_ns[p] / 1e6
+              << ", \"iterations\": " << phase_iterations[p]
+              << ", \"bytes\": " << phase_bytes[p] << "}"
+              << (p + 1 < phase_count ? "," : "") << std::endl;
+        }
+        out << "]}" << std::endl;
+        return;
+      }
+      double accounted_ms = 0;
+      out << std::left << std::setw(18) << "L1 phase" << std::right << std::setw(12) << "time (ms)" << std::setw(8) << "%"
+          << std::setw(12) << "iterations" << std::setw(14) << "heap bytes" << std::endl;
+      out << std::fixed << std::setprecision(3);
+      for (int p = 0; p < phase_count; p++) {
+        double ms = phase_ns[p] / 1e6;
+        accounted_ms += ms;
+        out << std::left << std::setw(18) << phase_names[p] << std::right << std::setw(12) << ms
+            << std::setw(7) << std::setprecision(1) << (total_ms > 0 ? 100 * ms / total_ms : 0) << "%"
+            << std::setprecision(3) << std::setw(12) << phase_iterations[p] << std::setw(14) << phase_bytes[p] << std::endl;
+      }
+      out << std::left << std::setw(18) << "other" << std::right << std::setw(12) << std::max(0.0, total_ms - accounted_ms) << std::endl;
+      out << std::left << std::setw(18) << "total" << std::right << std::setw(12) << total_ms << std::endl;
+    }
+
+}
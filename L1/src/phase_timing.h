@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace L1 {
+
+    /*
+    Where compile time goes, for -T; the L2 compiler keeps the same report for its own phases.
+    - a PhaseScope charges the time between its construction and its destruction to its phase, together with the
+      heap the phase grew (malloc'd bytes in use afterwards minus before). Every scope is one iteration of its phase.
+    - with -T off a PhaseScope only tests a flag.
+    */
+    enum class Phase : uint8_t {
+      parse,
+      code_generation
+    };
+    const int phase_count = 2;
+
+    extern bool phase_timing;       // -T
+
+    class PhaseScope {
+        public:
+            PhaseScope(Phase phase) : active(phase_timing) {
+              if (active) begin(phase);
+            }
+            ~PhaseScope() {
+              if (active) end();
+            }
+
+        private:
+            void begin(Phase phase);
+            void end();
+
+            bool active;
+            Phase phase;
+            std::chrono::steady_clock::time_point start;
+            int64_t start_bytes;
+    };
+
+    /*
+    The totals as a table, or as JSON with one phase per line; total_ms is the whole compilation.
+    */
+    void print_phase_report(std::ostream &out, bool json, double total_ms);
+
+}
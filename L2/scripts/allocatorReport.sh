@@ -0,0 +1,92 @@
+#!/bin/bash
+
+# Compile every test with the -r report on and add up what the register allocator did, per function and in total,
+# then compare it with a stored baseline (or, with -b, store it as the new baseline).
+# Exits with 1 when the spill loads and stores or the moves left over the whole corpus went up.
+if test $# -lt 1 ; then
+  echo "USAGE: `basename $0` [-b] BASELINE_FILE [COMPILER_ARGUMENTS]" ;
+  exit 1;
+fi
+updateBaseline=0 ;
+if test "$1" == "-b" ; then
+  updateBaseline=1 ;
+  shift ;
+fi
+baseline=$1 ;
+shift ;
+compilerArgs="$@" ;
+
+origDir=`pwd` ;
+workDir=`mktemp -d` ;
+current=${workDir}/current.tsv ;
+
+# One row per function: test, function, then the metrics in the order of the header
+printf "test\tfunction\tspilled_variables\trematerialized\tspill_loads\tspill_stores\tmoves\tframe_size\tcoloring_iterations\tallocation_ms\n" > ${current} ;
+for i in `ls tests/*.L2` ; do
+  printf "\r%-60s" $i ;
+  pushd ${workDir} &> /dev/null ;
+  ${origDir}/bin/L2 -r ${compilerArgs} ${origDir}/${i} 2> /dev/null | awk -v test=`basename $i` '
+    BEGIN { OFS = "\t" }
+    /"name"/ {
+      line = $0 ;
+      gsub(/[{}"]/, "", line) ;
+      sub(/,$/, "", line) ;
+      n = split(line, fields, ", ") ;
+      for (k = 1; k <= n; k++) {
+        split(fields[k], pair, ": ") ;
+        value[pair[1]] = pair[2] ;
+      }
+      print test, value["name"], value["spilled_variables"], value["rematerialized"], value["spill_loads"], value["spill_stores"], value["moves"], value["frame_size"], value["coloring_iterations"], value["allocation_ms"] ;
+    }' >> ${current} ;
+  popd &> /dev/null ;
+done
+printf "\r%-60s\r" "" ;
+
+if test ${updateBaseline} == "1" ; then
+  cut -f 1-9 ${current} > ${baseline} ;
+  echo "Baseline written to ${baseline}" ;
+  rm -rf ${workDir} ;
+  exit 0 ;
+fi
+if ! test -f ${baseline} ; then
+  echo "The baseline \"${baseline}\" does not exist, create it with -b" ;
+  rm -rf ${workDir} ;
+  exit 1 ;
+fi
+
+# Totals of both runs, and the functions whose spill code or moves grew
+awk '
+  BEGIN { FS = "\t" ; worse = 0 }
+  FNR == 1 {
+    for (m = 3; m <= NF; m++) name[m] = $m ;
+    next ;
+  }
+  NR == FNR {
+    base[$1 "\t" $2] = $0 ;
+    for (m = 3; m <= 9; m++) was[m] += $m ;
+    next ;
+  }
+  {
+    for (m = 3; m <= 10; m++) now[m] += $m ;
+    key = $1 "\t" $2 ;
+    if (!(key in base)) next ;
+    split(base[key], b, "\t") ;
+    if ($5 + $6 > b[5] + b[6] || $7 > b[7]) {
+      if (worse == 0) printf "%-40s %-12s %22s %22s\n", "regressed function", "", "spill loads+stores", "moves" ;
+      printf "%-40s %-12s %10d -> %-9d %10d -> %-9d\n", $1, $2, b[5] + b[6], $5 + $6, b[7], $7 ;
+      worse++ ;
+    }
+  }
+  END {
+    printf "\n%-22s %12s %12s %9s\n", "metric", "baseline", "current", "change" ;
+    for (m = 3; m <= 9; m++) {
+      change = (was[m] == 0) ? 0 : 100 * (now[m] - was[m]) / was[m] ;
+      printf "%-22s %12d %12d %8.1f%%\n", name[m], was[m], now[m], change ;
+    }
+    printf "%-22s %12s %12.1f\n", name[10], "", now[10] ;
+    printf "\n%d functions regressed\n", worse ;
+    exit (now[5] + now[6] > was[5] + was[6] || now[7] > was[7]) ? 1 : 0 ;
+  }' ${baseline} ${current} ;
+status=$? ;
+rm -rf ${workDir} ;
+exit ${status} ;
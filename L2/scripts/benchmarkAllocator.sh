@@ -0,0 +1,61 @@
+#!/bin/bash
+
+# Measure how the register allocator scales: generate programs over a grid of shapes with generateBenchmark.sh,
+# compile each with the -r report on and write one CSV row per program with the time of every allocation phase
+# (for @bench) and the peak memory of the compiler.
+# The grid can be narrowed or widened with space separated lists in SIZES (instructions), PRESSURES, LOOP_DEPTHS and
+# CALL_PERCENTS; every program has a quarter as many variables as instructions (at least PRESSURE).
+if test $# -lt 1 ; then
+  echo "USAGE: `basename $0` OUTPUT_CSV [COMPILER_ARGUMENTS]" ;
+  exit 1;
+fi
+output=$1 ;
+shift ;
+compilerArgs="$@" ;
+sizes=${SIZES:-"250 500 1000 2000 4000"} ;
+pressures=${PRESSURES:-"8 16 32"} ;
+loopDepths=${LOOP_DEPTHS:-"0 2"} ;
+callPercents=${CALL_PERCENTS:-"0 5"} ;
+
+origDir=`pwd` ;
+workDir=`mktemp -d` ;
+case ${output} in
+  /*) ;;
+  *) output=${origDir}/${output} ;;
+esac
+
+echo "instructions,variables,pressure,loop_depth,call_percent,allocation_ms,liveness_ms,graph_ms,coloring_ms,spill_ms,spilled_variables,coloring_iterations,peak_rss_kb" > ${output} ;
+for size in ${sizes} ; do
+  for pressure in ${pressures} ; do
+    variables=$(( size / 4 > pressure ? size / 4 : pressure )) ;
+    for loopDepth in ${loopDepths} ; do
+      for callPercent in ${callPercents} ; do
+        printf "\r%-60s" "${size} instructions, pressure ${pressure}, depth ${loopDepth}, calls ${callPercent}%" ;
+        ${origDir}/scripts/generateBenchmark.sh ${variables} ${size} ${pressure} ${loopDepth} ${callPercent} > ${workDir}/bench.L2 ;
+        pushd ${workDir} &> /dev/null ;
+        ${origDir}/bin/L2 -r ${compilerArgs} bench.L2 2> /dev/null | awk -v prefix="${size},${variables},${pressure},${loopDepth},${callPercent}" '
+          /peak_rss_kb/ {
+            split($0, fields, /[:,] */) ;
+            peak = fields[2] ;
+          }
+          /"name": "@bench"/ {
+            line = $0 ;
+            gsub(/[{}"]/, "", line) ;
+            sub(/,$/, "", line) ;
+            n = split(line, fields, ", ") ;
+            for (k = 1; k <= n; k++) {
+              split(fields[k], pair, ": ") ;
+              value[pair[1]] = pair[2] ;
+            }
+          }
+          END {
+            print prefix "," value["allocation_ms"] "," value["liveness_ms"] "," value["graph_ms"] "," value["coloring_ms"] "," value["spill_ms"] "," value["spilled_variables"] "," value["coloring_iterations"] "," peak ;
+          }' >> ${output} ;
+        popd &> /dev/null ;
+      done
+    done
+  done
+done
+printf "\r%-60s\r" "" ;
+echo "Results written to ${output}" ;
+rm -rf ${workDir} ;
@@ -0,0 +1,67 @@
+#!/bin/bash
+
+# Run a program on the interpreter as written and as the allocator leaves it (with the same arguments the compiler
+# would get), then print what every function executed in both runs: the difference is the exact dynamic cost of the
+# spill code and of the moves coalescing did not remove.
+# SOURCE.in, if it exists, is the program's input, as for the tests.
+if test $# -lt 1 ; then
+  echo "USAGE: `basename $0` SOURCE [COMPILER_ARGUMENTS]" ;
+  exit 1;
+fi
+source=$1 ;
+shift ;
+compilerArgs="$@" ;
+input=/dev/null ;
+if test -f ${source}.in ; then
+  input=${source}.in ;
+fi
+
+workDir=`mktemp -d` ;
+./bin/L2i -c ${source} < ${input} 2> ${workDir}/before.json > ${workDir}/before.out ;
+./bin/L2i -c -a ${compilerArgs} ${source} < ${input} 2> ${workDir}/after.json > ${workDir}/after.out ;
+if ! cmp -s ${workDir}/before.out ${workDir}/after.out ; then
+  echo "The allocated program prints something else than the original one" ;
+  rm -rf ${workDir} ;
+  exit 1 ;
+fi
+
+# One row per function, then the totals
+awk '
+  /"name"/ {
+    line = $0 ;
+    gsub(/[{}"]/, "", line) ;
+    sub(/,$/, "", line) ;
+    n = split(line, fields, ", ") ;
+    for (k = 1; k <= n; k++) {
+      split(fields[k], pair, ": ") ;
+      value[pair[1]] = pair[2] ;
+    }
+    name = value["name"] ;
+    if (FILENAME ~ /before/) {
+      order[++functions] = name ;
+      was[name, 1] = value["instructions"] ;
+      was[name, 2] = value["stack_loads"] + value["stack_stores"] ;
+      was[name, 3] = value["moves"] ;
+    } else {
+      now[name, 1] = value["instructions"] ;
+      now[name, 2] = value["stack_loads"] + value["stack_stores"] ;
+      now[name, 3] = value["moves"] ;
+    }
+  }
+  END {
+    printf "%-30s %27s %27s %27s\n", "function", "instructions", "stack loads+stores", "moves" ;
+    for (f = 1; f <= functions; f++) {
+      name = order[f] ;
+      printf "%-30s", name ;
+      for (m = 1; m <= 3; m++) {
+        printf " %12d -> %-12d", was[name, m], now[name, m] ;
+        total_was[m] += was[name, m] ;
+        total_now[m] += now[name, m] ;
+      }
+      printf "\n" ;
+    }
+    printf "%-30s", "total" ;
+    for (m = 1; m <= 3; m++) printf " %12d -> %-12d", total_was[m], total_now[m] ;
+    printf "\n" ;
+  }' ${workDir}/before.json ${workDir}/after.json ;
+rm -rf ${workDir} ;
@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# Write a synthetic L2 program for benchmarking the register allocator to stdout.
+# @main calls @bench once and prints what it returns; @bench has the requested shape:
+#   VARIABLES      how many distinct variables it uses
+#   INSTRUCTIONS   how many instructions its body has, about (sliding the window below adds a few)
+#   PRESSURE       how many variables are live at once, a window that slides over all of them from start to end
+#   LOOP_DEPTH     each quarter of the body sits in a nest of this many loops, two iterations each
+#   CALL_PERCENT   the share of the body's instructions that are calls to @leaf
+#   SEED           for the random choice of operands and operations, 1 by default
+if test $# -lt 5 ; then
+  echo "USAGE: `basename $0` VARIABLES INSTRUCTIONS PRESSURE LOOP_DEPTH CALL_PERCENT [SEED]" ;
+  exit 1;
+fi
+seed=${6:-1} ;
+
+awk -v variables=$1 -v instructions=$2 -v pressure=$3 -v depth=$4 -v calls=$5 -v seed=${seed} '
+  BEGIN {
+    srand(seed) ;
+    if (pressure > variables) pressure = variables ;
+    if (pressure < 2) pressure = 2 ;
+    if (variables < pressure) variables = pressure ;
+    segments = 4 ;
+    perSegment = int(instructions / segments) ;
+    if (perSegment < 1) perSegment = 1 ;
+
+    print "(@main" ;
+    print "  (@main" ;
+    print "  0" ;
+    print "    mem rsp -8 <- :main_ret" ;
+    print "    call @bench 0" ;
+    print "    :main_ret" ;
+    print "    rdi <- rax" ;
+    print "    rdi <<= 1" ;
+    print "    rdi += 1" ;
+    print "    call print 1" ;
+    print "    return" ;
+    print "  )" ;
+
+    print "  (@leaf" ;
+    print "  1" ;
+    print "    %x <- rdi" ;
+    print "    %x += 1" ;
+    print "    rax <- %x" ;
+    print "    return" ;
+    print "  )" ;
+
+    print "  (@bench" ;
+    print "  0" ;
+    print "    %acc <- 0" ;
+    for (v = 0; v < pressure; v++) print "    %v" v " <- " v ;
+
+    # The live window is [low, low + pressure); it moves up in step with the instruction count, the variable
+    # leaving it is folded into %acc so it stays live until then.
+    low = 0 ;
+    calls_made = 0 ;
+    total = segments * perSegment ;
+    for (s = 0; s < segments; s++) {
+      for (d = 0; d < depth; d++) {
+        print "    %c" s "_" d " <- 2" ;
+        print "    :loop" s "_" d ;
+      }
+      for (k = 0; k < perSegment; k++) {
+        target = int(((s * perSegment + k) * (variables - pressure)) / total) ;
+        while (low < target) {
+          print "    %acc += %v" low ;
+          print "    %v" (low + pressure) " <- " (low + pressure) ;
+          low++ ;
+        }
+        a = low + int(rand() * pressure) ;
+        b = low + int(rand() * pressure) ;
+        if (rand() * 100 < calls) {
+          print "    rdi <- %v" b ;
+          print "    mem rsp -8 <- :call" calls_made ;
+          print "    call @leaf 1" ;
+          print "    :call" calls_made ;
+          print "    %v" a " <- rax" ;
+          calls_made++ ;
+          continue ;
+        }
+        op = int(rand() * 4) ;
+        if (op == 0) print "    %v" a " += %v" b ;
+        else if (op == 1) print "    %v" a " -= %v" b ;
+        else if (op == 2) print "    %v" a " &= %v" b ;
+        else print "    %v" a " <- %v" b ;
+      }
+      for (d = depth - 1; d >= 0; d--) {
+        print "    %c" s "_" d " -= 1" ;
+        print "    cjump 0 < %c" s "_" d " :loop" s "_" d ;
+      }
+    }
+    for (v = low; v < low + pressure; v++) print "    %acc += %v" v ;
+    print "    rax <- %acc" ;
+    print "    return" ;
+    print "  )" ;
+    print ")" ;
+  }' ;
@@ -2,80 +2,160 @@
 
 namespace L2 {
 
-    int printdebug = 0;
+    std::atomic<int> printdebug(0);
+    std::mutex debug_output;
 
     /*
     Code Analysis.
     */
     Graph* analyze_L2(Function* fptr) {
+        Curr_F_Liveness liveness_results;
+        return analyze_L2(fptr, liveness_results);
+    }
+
+    Graph* analyze_L2(Function* fptr, Curr_F_Liveness& liveness_results) {
 
-        Curr_F_Liveness liveness_results = liveness_analysis(fptr);
+        liveness_results = liveness_analysis(fptr);
         if (printdebug) {
+            std::lock_guard<std::mutex> guard(debug_output);
             std::cerr << "printing in and out sets..." <<"\n";
             print_liveness(fptr, liveness_results);
         }
+        PhaseScope timer(Phase::interference, &fptr->stats.graph_ms);
         Graph* interference_graph = build_graph(fptr, liveness_results);
+        compute_spill_costs(fptr, interference_graph);
 
         return interference_graph;
     }
 
     /*
     Register Allocation.
+    - optLevel < 2 uses linear scan, otherwise graph coloring (with coalescing from -O2 up).
+    - -O3 solves each coloring attempt as a PBQP problem instead, within a work budget.
     */
-    Function* allocate_registers(Function* fptr) {
+    Function* allocate_registers(Function* fptr, int32_t optLevel) {
         Function* fptr_out;
         std::map<std::string, bool> seenVariables;
 
         /*
-        Make a deep copy of the original function in case the big fail case occurs.
+        With coalescing on, the callee-saved registers are allocatable too (saved where they are written, once
+        allocation is done).
+        */
+        if (optLevel >= 2) {
+            fptr->shrink_wrap = true;
+        }
+
+        /*
+        The analysis of the current function. After a normal spill round it is patched rather than redone,
+        interference_graph is null whenever it has to be computed from scratch.
         */
-        Function* original_function;
-        original_function = deepCopyFunction(fptr);
+        Curr_F_Liveness liveness_results;
+        Graph* interference_graph = nullptr;
 
         int spill_count = 0;
         int stack_counter = 0;
         bool big_fail = false;
+        int64_t big_fail_spills = 1;    // variables the next big fail spills
+        bool big_fail_spilled_all = false;  // the last big fail spilled every variable it could
+        bool use_linear_scan = (optLevel < 2);
+        fptr->stats.instructions = fptr->instructions.size();
         while (true) {
+            fptr->stats.coloring_iterations++;
+            if (use_linear_scan) {
+                /*
+                -O0/-O1: linear scan over live intervals instead of building and coloring the interference graph.
+                - spilled variables are rewritten the same way as below and the scan is redone.
+                - if even a spill temporary can't get a register, carry on with graph coloring from the current function.
+                */
+                fptr->stats.allocator = "linear scan";
+                std::tuple<bool, std::vector<Variable*>> scan_result;
+                {
+                    PhaseScope timer(Phase::coloring, &fptr->stats.coloring_ms);
+                    scan_result = linear_scan(fptr);
+                }
+                if (std::get<0>(scan_result)) {
+                    use_linear_scan = false;
+                    continue;
+                }
+                std::vector<Variable*> spilled_vars = std::get<1>(scan_result);
+                if (spilled_vars.empty()) {
+                    fptr_out = fptr;
+                    break;
+                }
+                fptr->stats.spilled_variables += spilled_vars.size();
+                PhaseScope timer(Phase::spill, &fptr->stats.spill_ms);
+                std::tuple<std::set<std::string>, int, int> spill_result = spill_variables(fptr, spilled_vars, spill_count, stack_counter);
+                spill_count = std::get<1>(spill_result);
+                stack_counter = std::get<2>(spill_result);
+                continue;
+            }
+
             /*
             We need to iterate until we are able to fully color each node in the 
             function's interference graph, or we spill everything.
             */
-            Graph* interference_graph = analyze_L2(fptr);
+            if (!interference_graph) interference_graph = analyze_L2(fptr, liveness_results);
             
-            if (printdebug) std::cerr << "Printing the graph:\n";
-            if (printdebug) interference_graph->printGraph();
-            Graph* interference_graph_copy = interference_graph->clone();
-
-            std::tuple<bool, std::vector<Node*>> color_result = color_graph(interference_graph, interference_graph_copy, fptr);
+            if (printdebug) {
+                std::lock_guard<std::mutex> guard(debug_output);
+                std::cerr << "Printing the graph:\n";
+                interference_graph->printGraph();
+            }
+            fptr->stats.allocator = (optLevel >= 3) ? "pbqp" : (optLevel >= 2) ? "coalescing" : "coloring";
+            Graph* interference_graph_copy;
+            std::tuple<bool, std::vector<Node*>> color_result;
+            {
+                PhaseScope timer(Phase::coloring, &fptr->stats.coloring_ms);
+                interference_graph_copy = interference_graph->clone();
+                color_result = (optLevel >= 3)
+                    ? color_graph_pbqp(interference_graph, interference_graph_copy, fptr)
+                    : (optLevel >= 2)
+                    ? color_graph_coalescing(interference_graph, interference_graph_copy, fptr)
+                    : color_graph(interference_graph, interference_graph_copy, fptr);
+            }
 
             big_fail = std::get<0>(color_result);
             std::vector<Node*> uncolored_nodes = std::get<1>(color_result);
             if (big_fail) {
                 /*
-                Create an interference graph from the original function.
-                */
-                Graph* original_function_interference_graph = analyze_L2(original_function);
-
-                /*
-                Get a vector of its variable nodes to iterate over - we will spill each one.
-                */
-                std::vector<Node*> variable_nodes_vec = original_function_interference_graph->getVarNodes();
-
-                /*
-                Iterate over each of these nodes, spilling and getting the updated functions.
-                - the order we do this shouldn't really matter.
+                Only spill temporaries were left without a color, and those can't be spilled. Make room for them by
+                spilling other variables, cheapest first by spill cost per degree (the order the colorer spills in),
+                twice as many every time the graph still doesn't color. At worst every variable ends up spilled,
+                which is what this path used to do straight away.
+                - a variable whose name merely starts with %S has an infinite cost too (the colorers take it for a
+                  temporary), so it can only be made room for here; it sorts last.
+                If there is nothing left to spill, or the last round already spilled everything and the graph
+                still doesn't color, retrying can't help: give up instead of looping.
                 */
-                while (!variable_nodes_vec.empty()) {
-                    Node* var_node = variable_nodes_vec.back();
-                    variable_nodes_vec.pop_back();
-                    Variable* variable = var_node->var;
-                    std::tuple<std::set<std::string>,L2::Function*,int> spill_result = L2::spillForL2(fptr, variable, spill_count, stack_counter);
-                    std::set<std::string> spilled_set = std::get<0>(spill_result);
-                    L2::Function* newFunction = std::get<1>(spill_result);
-                    spill_count = std::get<2>(spill_result);
-                    fptr = newFunction;
-                    stack_counter++;
+                std::vector<Node*> candidates;
+                for (auto node : interference_graph->getVarNodes()) {
+                    if (!interference_graph->spill_vars.count(node->var)) candidates.push_back(node);
+                }
+                auto cost_per_degree = [&](Node *node) {
+                    return node->spill_cost / (double)std::max<size_t>(1, interference_graph->adjacency[node->id].size());
+                };
+                if (candidates.empty() || big_fail_spilled_all) {
+                    std::cerr << "Error: " << fptr->name << ": spill temporaries can't be colored even with every variable spilled" << std::endl;
+                    exit(1);
                 }
+                std::stable_sort(candidates.begin(), candidates.end(), [&](Node *a, Node *b) {
+                    return cost_per_degree(a) < cost_per_degree(b);
+                });
+                big_fail_spilled_all = ((int64_t)candidates.size() <= big_fail_spills);
+                if (!big_fail_spilled_all) candidates.resize(big_fail_spills);
+                big_fail_spills *= 2;
+                if (debug) std::cerr << fptr->name << ": spill temporaries left uncolored, spilling " << candidates.size() << " variables" << std::endl;
+
+                std::vector<Variable*> spilled_vars;
+                for (auto node : candidates) {
+                    spilled_vars.push_back(node->var);
+                }
+                fptr->stats.spilled_variables += spilled_vars.size();
+                PhaseScope timer(Phase::spill, &fptr->stats.spill_ms);
+                std::tuple<std::set<std::string>, int, int> spill_result = spill_variables(fptr, spilled_vars, spill_count, stack_counter);
+                spill_count = std::get<1>(spill_result);
+                stack_counter = std::get<2>(spill_result);
+                interference_graph = nullptr;
                 /*
                 We shouldn't break, since we still need to color this updated function which is now stored in fptr.
                 */
@@ -95,6 +175,11 @@ namespace L2 {
                 for (Instruction *iptr : fptr->instructions) {
                     iptr->accept(&myColorVisitor);
                 }
+
+                /*
+                Moves between coalesced variables now read "r <- r", drop them.
+                */
+                remove_coalesced_moves(fptr);
                 fptr_out = fptr;
                 break;
 
@@ -104,31 +189,43 @@ namespace L2 {
                 Graph coloring failed, need to spill.
                 */ 
 
-                for (auto node : uncolored_nodes) {
-
-                    if (printdebug) {
-                        std::cerr << "Printing program before spill:\n\n";
-                        printFunction(fptr);
-                    }
+                if (printdebug) {
+                    std::lock_guard<std::mutex> guard(debug_output);
+                    std::cerr << "Printing program before spill:\n\n";
+                    printFunction(fptr);
+                }
 
-                    std::tuple<std::set<std::string>, L2::Function *,int> spill_result = spillForL2(fptr, node->var, spill_count,stack_counter);
-                    std::set<std::string> spilled_set = std::get<0>(spill_result);
-                    L2::Function* newFunction = std::get<1>(spill_result);
-                    spill_count = std::get<2>(spill_result);
+                std::vector<Variable*> spilled_vars;
+                for (auto node : uncolored_nodes) {
+                    spilled_vars.push_back(node->var);
                     seenVariables[node->var->name] = true;
-                    fptr = newFunction;
-                    spill_count++;
-                    
-                    if (printdebug) {
-                        std::cerr << "Printing program after spill:\n\n";
-                        printFunction(fptr);
-                    }
-                    stack_counter++;
-                }   
+                }
+                fptr->stats.spilled_variables += spilled_vars.size();
+                PhaseScope timer(Phase::spill, &fptr->stats.spill_ms);
+                std::vector<SpillRewrite> rewrites;
+                std::tuple<std::set<std::string>, int, int> spill_result = spill_variables(fptr, spilled_vars, spill_count, stack_counter, &rewrites);
+                spill_count = std::get<1>(spill_result);
+                stack_counter = std::get<2>(spill_result);
+                interference_graph = update_analysis_after_spill(fptr, liveness_results, interference_graph, rewrites, spilled_vars);
+
+                if (printdebug) {
+                    std::lock_guard<std::mutex> guard(debug_output);
+                    std::cerr << "Printing program after spill:\n\n";
+                    printFunction(fptr);
+                }
             }
 
         }
 
+        /*
+        Reuse reloads that are still in a register, then let spilled values that are never live at the same time share
+        a stack slot (this also sets fptr_out->locals) and save the callee-saved registers the function writes.
+        */
+        reuse_spill_reloads(fptr_out);
+        allocate_stack_slots(fptr_out);
+        if (fptr_out->shrink_wrap) shrink_wrap_callee_saves(fptr_out);
+        finish_allocation_stats(fptr_out);
+
         return fptr_out;
     }
 
@@ -153,10 +250,13 @@ namespace L2 {
         }
     }
     // Register, derived from Variable
-    Variable::Variable(std::string name) : name(name) { 
+    Variable::Variable(std::string name) : Item(ItemKind::variable), name(name) { 
    
     }
-    Register::Register(std::string r) : Variable(r), name(r) {
+    Variable::Variable(std::string name, ItemKind kind) : Item(kind), name(name) {
+
+    }
+    Register::Register(std::string r) : Variable(r, ItemKind::reg), name(r) {
 
     }
     std::string Register::print() {
@@ -172,7 +272,7 @@ namespace L2 {
     }
 
     Number::Number (int64_t n)
-        : value {n}{
+        : Item(ItemKind::number), value {n}{
         return ;
     }
     std::string Number::translate () {
@@ -183,7 +283,7 @@ namespace L2 {
     }
 
     Name::Name (const std::string &value)
-        : value {value}{
+        : Item(ItemKind::name), value {value}{
         return ;    
     }
     std::string Name::translate () {
@@ -195,7 +295,7 @@ namespace L2 {
     }
 
     Label::Label (const std::string &value)
-        : value {value}{
+        : Item(ItemKind::label), value {value}{
         return ;
     }
     std::string Label::translate () {
@@ -206,7 +306,7 @@ namespace L2 {
     }
 
     Operator::Operator (const std::string &sign)
-        : sign {sign} {
+        : Item(ItemKind::op), sign {sign} {
         return;
     }
     std::string Operator::translate() {
@@ -264,7 +364,7 @@ namespace L2 {
     Instruction class extensions
     */
 
-    Instruction_ret::Instruction_ret() {}
+    Instruction_ret::Instruction_ret() : Instruction(InstructionKind::ret) {}
     void Instruction_ret::printMe() {
         std::cout << "Instruction_ret:    return" << std::endl;
     }
@@ -272,7 +372,7 @@ namespace L2 {
     // Instruction_assignment Constructor
     // Instruction_assignment::Instruction_assignment(Item *dst, Item *src) : s(src), d(dst) {}
     Instruction_assignment::Instruction_assignment (Item *dst, Item *src)
-        : s { src },
+        : Instruction(InstructionKind::assignment), s { src },
         d { dst } {
         return ;
     }
@@ -291,13 +391,14 @@ namespace L2 {
     // at_instruction::at_instruction(Item *reg1, Item *reg2, Item *reg3, Integer *num) : reg1(reg1), reg2(reg2), reg3(reg3), num(num) {}
 
     // label_Instruction Constructor
-    label_Instruction::label_Instruction(Item *label) : label(label) {}
+    label_Instruction::label_Instruction(Item *label) : Instruction(InstructionKind::label), label(label) {}
+    label_Instruction::label_Instruction(Item *label, InstructionKind kind) : Instruction(kind), label(label) {}
     void label_Instruction::printMe() {
 
     }
 
     // goto_label_instruction Constructor
-    goto_label_instruction::goto_label_instruction(Item *label) : label_Instruction(label) {}
+    goto_label_instruction::goto_label_instruction(Item *label) : label_Instruction(label, InstructionKind::goto_label) {}
     void goto_label_instruction::printMe() {
 
     }
@@ -311,99 +412,99 @@ namespace L2 {
     // }
 
     // Call_tenserr_Instruction Constructor
-    Call_tenserr_Instruction::Call_tenserr_Instruction(Item *F) : F(F) {}
+    Call_tenserr_Instruction::Call_tenserr_Instruction(Item *F) : Instruction(InstructionKind::call_tenserr), F(F) {}
     void Call_tenserr_Instruction::printMe() {
 
     }
 
     // Call_uN_Instruction Constructor
-    Call_uN_Instruction::Call_uN_Instruction(Item *u, Item *N) : u(u), N(N) {}
+    Call_uN_Instruction::Call_uN_Instruction(Item *u, Item *N) : Instruction(InstructionKind::call_uN), u(u), N(N) {}
     void Call_uN_Instruction::printMe() {
 
     }
 
-    Memory_assignment_store::Memory_assignment_store(Item *dst, Item *s, Item *M) : dst(dst), s(s), M(M) {}
+    Memory_assignment_store::Memory_assignment_store(Item *dst, Item *s, Item *M) : Instruction(InstructionKind::memory_store), dst(dst), s(s), M(M) {}
     void Memory_assignment_store::printMe() {
         std::cout << "Memory_assignment_store:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", s = " << this->s->translate() << std::endl;
     }
 
-    Memory_assignment_load::Memory_assignment_load(Item *dst, Item *x, Item *M) : dst(dst), x(x), M(M) {}
+    Memory_assignment_load::Memory_assignment_load(Item *dst, Item *x, Item *M) : Instruction(InstructionKind::memory_load), dst(dst), x(x), M(M) {}
     void Memory_assignment_load::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", x = " << this->x->translate() << std::endl;
     }
     
     // Memory_arithmetic Constructor
     Memory_arithmetic_load::Memory_arithmetic_load(Item *dst, Item *x, Item *instruction, Item *M) 
-    : dst(dst), x(x), instruction(instruction), M(M) {}
+    : Instruction(InstructionKind::memory_arithmetic_load), dst(dst), x(x), instruction(instruction), M(M) {}
     void Memory_arithmetic_load::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", x = " << this->x->translate() << ", instruction = " << this->instruction->translate() << std::endl;
     }
 
     Memory_arithmetic_store::Memory_arithmetic_store(Item *dst, Item *t, Item *instruction, Item *M) 
-    : dst(dst), t(t), instruction(instruction), M(M) {}
+    : Instruction(InstructionKind::memory_arithmetic_store), dst(dst), t(t), instruction(instruction), M(M) {}
     void Memory_arithmetic_store::printMe() {
         std::cout << "Memory_assignment_load:    " << "dst = " << this->dst->translate() << ", M = " << this->M->translate() << ", t = " << this->t->translate() << ", instruction = " << this->instruction->translate() << std::endl;
     }
     
     // cmp_Instruction Constructor
-    cmp_Instruction::cmp_Instruction(Item *dst, Item *t2, Item *method, Item *t1) : dst(dst), t1(t1), method(method), t2(t2) {}
+    cmp_Instruction::cmp_Instruction(Item *dst, Item *t2, Item *method, Item *t1) : Instruction(InstructionKind::cmp), dst(dst), t1(t1), method(method), t2(t2) {}
     void cmp_Instruction::printMe() {
 
     }
 
     // cjump_cmp_Instruction Constructor
-    cjump_cmp_Instruction::cjump_cmp_Instruction(Item *t2, Item *cmp, Item *t1, Item *label) : t2(t2), cmp(cmp), t1(t1), label(label) {}
+    cjump_cmp_Instruction::cjump_cmp_Instruction(Item *t2, Item *cmp, Item *t1, Item *label) : Instruction(InstructionKind::cjump), t2(t2), cmp(cmp), t1(t1), label(label) {}
     void cjump_cmp_Instruction::printMe() {
 
     }
 
     // AOP_assignment ConstructorInstruction_assignment(dst, src),
-    AOP_assignment::AOP_assignment(Item *method, Item *dst, Item *src) : src(src), dst(dst), method(method) {}
+    AOP_assignment::AOP_assignment(Item *method, Item *dst, Item *src) : Instruction(InstructionKind::aop), src(src), dst(dst), method(method) {}
     void AOP_assignment::printMe() {
         std::cout << "AOP_assignment:    " << "d = " << this->dst->translate() << ", method = " << this->method->translate() << ", s = " << this->src->translate() << std::endl;
     }
 
     // SOP_assignment Constructor
-    SOP_assignment::SOP_assignment(Item *method, Item *dst, Item *src) : src(src), dst(dst), method(method) {}
+    SOP_assignment::SOP_assignment(Item *method, Item *dst, Item *src) : Instruction(InstructionKind::sop), src(src), dst(dst), method(method) {}
     void SOP_assignment::printMe() {
         std::cout << "SOP_assignment:    " << "d = " << this->dst->print() << ", method = " << this->method->print() << ", s = " << this->src->print() << std::endl;
     }
 
-    Call_print_Instruction::Call_print_Instruction() {}
+    Call_print_Instruction::Call_print_Instruction() : Instruction(InstructionKind::call_print) {}
     void Call_print_Instruction::printMe() {
 
     }
 
-    Call_input_Instruction::Call_input_Instruction() {}
+    Call_input_Instruction::Call_input_Instruction() : Instruction(InstructionKind::call_input) {}
     void Call_input_Instruction::printMe() {
 
     }
 
-    Call_allocate_Instruction::Call_allocate_Instruction() {}
+    Call_allocate_Instruction::Call_allocate_Instruction() : Instruction(InstructionKind::call_allocate) {}
     void Call_allocate_Instruction::printMe() {
 
     }
 
-    Call_tuple_Instruction::Call_tuple_Instruction() {}
+    Call_tuple_Instruction::Call_tuple_Instruction() : Instruction(InstructionKind::call_tuple) {}
     void Call_tuple_Instruction::printMe() {
 
     }
 
     w_increment_decrement::w_increment_decrement(Item *r, Item *symbol) 
-        : r(r), symbol(symbol) {
+        : Instruction(InstructionKind::increment_decrement), r(r), symbol(symbol) {
     }
     void w_increment_decrement::printMe() {
         std::cout << "w_increment_decrement:    " << "r = " << this->r->translate() << ", symbol = " << this->symbol->translate() << std::endl;
     }
 
     w_atreg_assignment::w_atreg_assignment(Item *r1, Item *r2, Item *r3, Item *E) 
-        : r1(r1), r2(r2), r3(r3), E(E) {
+        : Instruction(InstructionKind::atreg), r1(r1), r2(r2), r3(r3), E(E) {
     }
     void w_atreg_assignment::printMe() {
     }
 
     stackarg_assignment::stackarg_assignment(Item *w, Item *M)
-        : w(w), M(M) {
+        : Instruction(InstructionKind::stackarg), w(w), M(M) {
     }
     void stackarg_assignment::printMe()
     {
@@ -518,93 +619,65 @@ namespace L2 {
     }
     
     void Function::calculateCFG(void){
+        PhaseScope timer(Phase::cfg);
         /*
-        1. We need to first clear the previous predecessors/successors
-        2. We then need to collect all of the jump function within this->instructions
-        3. Find the predecessors 
-        4. Find the successors 
+        1. We need to collect all of the jump function within this->instructions, by the label they jump to
+        2. Find the predecessors of every instruction, as (predecessor, instruction) position pairs
+        3. Hand the edges to the tables, which store them both ways (successors and predecessors)
+        Instructions are told apart by their kind tag.
         */
-        std::set<Instruction *> total_cjump_instructions{};
-        // for (auto instruction : this->instructions){
-        for (auto instruction : instructions) {
-            auto cast_instruction = dynamic_cast<cjump_cmp_Instruction *>(instruction);
-            auto goto_instruction = dynamic_cast<goto_label_instruction*>(instruction);
-            instruction->predecessors.clear(); // clearing out the predecessors
-            instruction->successors.clear(); //clearing out the successors
-            if (cast_instruction){
-                total_cjump_instructions.insert(cast_instruction);
+        std::unordered_map<std::string, std::vector<int64_t>> jumps_to;
+        int64_t count = instructions.size();
+        for (int64_t i = 0; i < count; i++) {
+            Label *target = as_label(jump_target(instructions[i]));
+            if (target) {
+                jumps_to[target->value].push_back(i);
             }
-            if (goto_instruction){
-                total_cjump_instructions.insert(goto_instruction);
-            }
-            ;
         }
-        Instruction *prev = nullptr;
-        for (auto instruction: this->instructions){
-            // if (debug) std::cerr<<"we iterating";
-            auto tenserr_cast = dynamic_cast<Call_tenserr_Instruction *>(prev);
-            auto ret_cast = dynamic_cast<Instruction_ret*>(prev);
-            auto tuple_err = dynamic_cast<Call_tuple_Instruction*>(prev);
-            auto goto_cast = dynamic_cast<goto_label_instruction*>(prev);
-            auto cjump_cast = dynamic_cast<cjump_cmp_Instruction *>(prev);
-            auto label_cast = dynamic_cast<label_Instruction*>(instruction);
-            if (!prev && !label_cast){
-                prev = instruction;
+        std::vector<std::pair<int64_t, int64_t>> edges;
+        int64_t prev = -1;
+        for (int64_t i = 0; i < count; i++){
+            Instruction *instruction = instructions[i];
+            bool is_label = instruction->kind == InstructionKind::label;
+            if (prev == -1 && !is_label && instruction->kind != InstructionKind::goto_label){
+                prev = i;
                 continue;
             }
-            if (tenserr_cast || ret_cast || tuple_err || goto_cast||!prev){
-            } else{
-                instruction->predecessors.insert(prev);
+            /*
+            Only an instruction that can fall through is a predecessor of the next one.
+            */
+            bool falls_through = prev != -1;
+            if (prev != -1) {
+                switch (instructions[prev]->kind) {
+                    case InstructionKind::call_tenserr:
+                    case InstructionKind::ret:
+                    case InstructionKind::call_tuple:
+                    case InstructionKind::goto_label:
+                        falls_through = false;
+                        break;
+                    default:
+                        break;
+                }
             }
-            auto check_goto_cast = dynamic_cast<goto_label_instruction*>(instruction);
-            if (check_goto_cast){
-                prev = instruction;
-                continue;
+            if (falls_through) {
+                edges.push_back({prev, i});
             }
             // everything that the previous one WILL be this instruciton predecessor 
             // essentially we know that if the instruction is NOT A LABEL that everything before it 
             // will be a predecessor
-            if (!label_cast){
-                prev = instruction;
+            if (!is_label){
+                prev = i;
                 continue;
             };
-            for (auto jump_label : total_cjump_instructions){
-                auto cast_label = dynamic_cast<cjump_cmp_Instruction *>(jump_label);
-                auto goto_label = dynamic_cast<goto_label_instruction*>(jump_label);
-                Label* compare_label = nullptr; // Initialize to nullptr
-                std::string compare;
-                
-                if (cast_label){
-                    compare_label = dynamic_cast<Label *>(cast_label->label);
-                    if (compare_label) { // Make sure the dynamic_cast was successful
-                        compare = compare_label->value;
-                    }
-                } else if (goto_label) {
-                    compare_label = dynamic_cast<Label *>(goto_label->label);
-                    if (compare_label) { // Make sure the dynamic_cast was successful
-                        compare = compare_label->value;
-                    }
-                }
-                if (compare_label && compare == label_cast->getLabel()){ 
-                    instruction->predecessors.insert(jump_label);
-                }
+            auto jumps = jumps_to.find(static_cast<label_Instruction *>(instruction)->getLabel());
+            if (jumps != jumps_to.end()) {
+                for (auto source : jumps->second) edges.push_back({source, i});
             }
-            // if (debug) std::cerr<<"post label cast";
 
-            prev = instruction;
+            prev = i;
             
         };
-        for (auto instruction: this->instructions){
-            for (auto predecessor: instruction->predecessors){
-                predecessor->successors.insert(instruction);
-            }
-        }
-        // for (auto instruction: this->instructions){
-        //     // if (debug) std::cerr<<"printing successors"<<std::endl;
-        //     for (auto successor : instruction->successors) {
-        //         successor->printMe();
-        //     }
-        // }
+        tables.set_cfg(count, edges);
     }   
 
     /*
@@ -615,11 +688,11 @@ namespace L2 {
     }
 
     void UseDefVisitor::visit(Instruction_assignment * instruction) {
-        Variable* var = dynamic_cast<Variable*>(instruction->s);
+        Variable* var = as_variable(instruction->s);
         if (var){
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->s));
+            used->insert(as_variable(instruction->s));
         }
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->d));
+        defined->insert(as_variable(instruction->d));
     }
 
     void UseDefVisitor::visit(label_Instruction *instruction) {
@@ -651,95 +724,95 @@ namespace L2 {
     }
 
     void UseDefVisitor::visit(Call_uN_Instruction * instruction) {
-        Variable* var = dynamic_cast<Variable*>(instruction->u);
+        Variable* var = as_variable(instruction->u);
         if (var){
-            instruction->used.insert(var);
+            used->insert(var);
         };
     }
     
     void UseDefVisitor::visit(w_increment_decrement *instruction) {
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->r));
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->r));
+        used->insert(as_variable(instruction->r));
+        defined->insert(as_variable(instruction->r));
     }
 
     void UseDefVisitor::visit(w_atreg_assignment *instruction) {
         // last two W's are going to be gen
         // the first w is going to be kill
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->r3));
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->r2));
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->r1));
+        used->insert(as_variable(instruction->r3));
+        used->insert(as_variable(instruction->r2));
+        defined->insert(as_variable(instruction->r1));
     }
 
     void UseDefVisitor::visit(Memory_assignment_store *instruction) {
         // src is of type s, which can be either a variable, register, number, lable, or I name
-        Variable* s_cast = dynamic_cast<Variable*>(instruction->s);
-        if (s_cast) instruction->used.insert(s_cast);
-        Variable* d_cast = dynamic_cast<Variable*>(instruction->dst);
+        Variable* s_cast = as_variable(instruction->s);
+        if (s_cast) used->insert(s_cast);
+        Variable* d_cast = as_variable(instruction->dst);
         if (d_cast->name != "rsp"){
-            instruction->used.insert(d_cast);
+            used->insert(d_cast);
         }
     }
 
     void UseDefVisitor::visit(Memory_assignment_load *instruction) {
-        Variable* x_cast = dynamic_cast<Variable*>(instruction->x);
+        Variable* x_cast = as_variable(instruction->x);
         if (x_cast->name != "rsp") {
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->x));
+            used->insert(as_variable(instruction->x));
         }
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));
+        defined->insert(as_variable(instruction->dst));
     }
 
     void UseDefVisitor::visit(Memory_arithmetic_load *instruction) {
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->x));
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->dst));
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));
+        used->insert(as_variable(instruction->x));
+        used->insert(as_variable(instruction->dst));
+        defined->insert(as_variable(instruction->dst));
     }
 
     void UseDefVisitor::visit(Memory_arithmetic_store *instruction) {
-        Variable* t_cast = dynamic_cast<Variable*>(instruction->t);
-        if (t_cast) instruction->used.insert(t_cast);
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));  
+        Variable* t_cast = as_variable(instruction->t);
+        if (t_cast) used->insert(t_cast);
+        defined->insert(as_variable(instruction->dst));  
     }
 
     void UseDefVisitor::visit(cmp_Instruction *instruction) {
-        Variable* var1 = dynamic_cast<Variable*>(instruction->t1);
-        Variable* var2 = dynamic_cast<Variable*>(instruction->t2);
+        Variable* var1 = as_variable(instruction->t1);
+        Variable* var2 = as_variable(instruction->t2);
         if (var1){
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->t1)); 
+            used->insert(as_variable(instruction->t1)); 
         }
         if (var2){
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->t2)); 
+            used->insert(as_variable(instruction->t2)); 
         }
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));
+        defined->insert(as_variable(instruction->dst));
     }
 
     void UseDefVisitor::visit(cjump_cmp_Instruction *instruction) {
-        Variable* var1 = dynamic_cast<Variable*>(instruction->t1);
-        Variable* var2 = dynamic_cast<Variable*>(instruction->t2);
+        Variable* var1 = as_variable(instruction->t1);
+        Variable* var2 = as_variable(instruction->t2);
         if (var1){
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->t1)); 
+            used->insert(as_variable(instruction->t1)); 
         }
         if (var2){
-            instruction->used.insert(dynamic_cast<Variable*>(instruction->t2)); 
+            used->insert(as_variable(instruction->t2)); 
         }
 
     }
 
     void UseDefVisitor::visit(stackarg_assignment *instruction) {
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->w)); 
+        defined->insert(as_variable(instruction->w)); 
     }
 
     void UseDefVisitor::visit(AOP_assignment * instruction) {
-        Variable* src_cast = dynamic_cast<Variable*>(instruction->src);
-        if (src_cast) instruction->used.insert(src_cast);
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->dst));
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));
+        Variable* src_cast = as_variable(instruction->src);
+        if (src_cast) used->insert(src_cast);
+        used->insert(as_variable(instruction->dst));
+        defined->insert(as_variable(instruction->dst));
     }
 
     void UseDefVisitor::visit(SOP_assignment *instruction){
-        Variable* src_cast = dynamic_cast<Variable*>(instruction->src);
-        if (src_cast) instruction->used.insert(src_cast);
-        instruction->used.insert(dynamic_cast<Variable*>(instruction->dst));
-        instruction->defined.insert(dynamic_cast<Variable*>(instruction->dst));
+        Variable* src_cast = as_variable(instruction->src);
+        if (src_cast) used->insert(src_cast);
+        used->insert(as_variable(instruction->dst));
+        defined->insert(as_variable(instruction->dst));
     }
     bool SpillVisitor::replaceIfSpilled(Item*& item) {
         auto variable = dynamic_cast<Variable*>(item);
@@ -1324,12 +1397,40 @@ namespace L2 {
     Calculate the Use/Def sets by running over each instruction's visit method
     */
     void Function::calculateUseDefs(){
+        PhaseScope timer(Phase::use_def);
+        /*
+        Always rebuilt from scratch: the instructions may have been renamed in place since the last run.
+        */
+        tables.set_use_defs(instructions.size());
         UseDefVisitor visitor;
-        // for (auto instruction: this->instructions){
-        for (auto instruction: instructions) {
-            instruction->accept(&visitor);
+        for (size_t i = 0; i < instructions.size(); i++) {
+            visitor.used = &tables.used[i];
+            visitor.defined = &tables.defined[i];
+            instructions[i]->accept(&visitor);
         };
     }
+
+    const ControlFlowGraph& Function::control_flow(){
+        if (!control_flow_graph.valid) control_flow_graph.build(this);
+        return control_flow_graph;
+    }
+
+    void Function::invalidate_analysis(){
+        tables.invalidate();
+        control_flow_graph.clear();
+    }
+    void Function::invalidate_control_flow(){
+        tables.invalidate_cfg();
+        control_flow_graph.clear();
+    }
+    void Function::release_code(){
+        invalidate_analysis();
+        std::vector<Instruction *>().swap(instructions);
+        variable_allocator = VariableAllocator();
+        spilled_variables.clear();
+        spill_variables_set.clear();
+        string_spill_variables_set.clear();
+    }
     void ColorVariablesVisitor::colorVar(Variable * &var) {
         // Node* correspondingNode = color_graph->nodes[var];
         // if (correspondingNode) {
@@ -1363,13 +1464,13 @@ namespace L2 {
     void ColorVariablesVisitor::visit(Instruction_ret * instruction) {
     }
     void ColorVariablesVisitor::visit(Instruction_assignment *instruction) {
-        auto s = dynamic_cast<Variable*>(instruction->s);
-        auto d = dynamic_cast<Variable*>(instruction->d);
+        auto s = as_variable(instruction->s);
+        auto d = as_variable(instruction->d);
         colorVar(s);
         colorVar(d);
     }
     void ColorVariablesVisitor::visit(label_Instruction *instruction) {
-        auto label = dynamic_cast<Variable*>(instruction->label);
+        auto label = as_variable(instruction->label);
         colorVar(label);
     }
     void ColorVariablesVisitor::visit(goto_label_instruction *instruction) {
@@ -1387,73 +1488,73 @@ namespace L2 {
     void ColorVariablesVisitor::visit(Call_tuple_Instruction *instruction) {
     }
     void ColorVariablesVisitor::visit(w_increment_decrement *instruction) {
-        auto r = dynamic_cast<Variable*>(instruction->r);
+        auto r = as_variable(instruction->r);
         colorVar(r);
     }
     void ColorVariablesVisitor::visit(w_atreg_assignment *instruction) {
-        auto r1 = dynamic_cast<Variable*>(instruction->r1);
-        auto r2 = dynamic_cast<Variable*>(instruction->r2);
-        auto r3 = dynamic_cast<Variable*>(instruction->r3);
+        auto r1 = as_variable(instruction->r1);
+        auto r2 = as_variable(instruction->r2);
+        auto r3 = as_variable(instruction->r3);
         colorVar(r1);
         colorVar(r2);
         colorVar(r3);
 
     }
     void ColorVariablesVisitor::visit(Memory_assignment_store *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto s = dynamic_cast<Variable*>(instruction->s);
+        auto dst = as_variable(instruction->dst);
+        auto s = as_variable(instruction->s);
         colorVar(dst);
         colorVar(s);
     }
     void ColorVariablesVisitor::visit(Memory_assignment_load *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto x = dynamic_cast<Variable*>(instruction->x);
+        auto dst = as_variable(instruction->dst);
+        auto x = as_variable(instruction->x);
         colorVar(dst);
         colorVar(x);
 
     }
     void ColorVariablesVisitor::visit(Memory_arithmetic_load *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto x = dynamic_cast<Variable*>(instruction->x);
+        auto dst = as_variable(instruction->dst);
+        auto x = as_variable(instruction->x);
         colorVar(dst);
         colorVar(x);
     }
     void ColorVariablesVisitor::visit(Memory_arithmetic_store *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto t = dynamic_cast<Variable*>(instruction->t);
+        auto dst = as_variable(instruction->dst);
+        auto t = as_variable(instruction->t);
         colorVar(dst);
         colorVar(t);
     }
     void ColorVariablesVisitor::visit(cmp_Instruction *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto t1 = dynamic_cast<Variable*>(instruction->t1);
-        auto t2 = dynamic_cast<Variable*>(instruction->t2);
+        auto dst = as_variable(instruction->dst);
+        auto t1 = as_variable(instruction->t1);
+        auto t2 = as_variable(instruction->t2);
         colorVar(dst);
         colorVar(t1);
         colorVar(t2);
 
     }
     void ColorVariablesVisitor::visit(cjump_cmp_Instruction *instruction) {
-        auto label = dynamic_cast<Variable*>(instruction->label);
-        auto t1 = dynamic_cast<Variable*>(instruction->t1);
-        auto t2 = dynamic_cast<Variable*>(instruction->t2);
+        auto label = as_variable(instruction->label);
+        auto t1 = as_variable(instruction->t1);
+        auto t2 = as_variable(instruction->t2);
         colorVar(label);
         colorVar(t1);
         colorVar(t2);
     }
     void ColorVariablesVisitor::visit(stackarg_assignment *instruction) {
-        auto w = dynamic_cast<Variable*>(instruction->w);
+        auto w = as_variable(instruction->w);
         colorVar(w);
     }
     void ColorVariablesVisitor::visit(AOP_assignment *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto src = dynamic_cast<Variable*>(instruction->src);
+        auto dst = as_variable(instruction->dst);
+        auto src = as_variable(instruction->src);
         colorVar(dst);        
         colorVar(src);
     }
     void ColorVariablesVisitor::visit(SOP_assignment *instruction) {
-        auto dst = dynamic_cast<Variable*>(instruction->dst);
-        auto src = dynamic_cast<Variable*>(instruction->src);
+        auto dst = as_variable(instruction->dst);
+        auto src = as_variable(instruction->src);
         colorVar(dst);        
         colorVar(src);
     }
@@ -1664,6 +1765,7 @@ namespace L2 {
         new_function->name = fptr->name;
         new_function->arguments = fptr->arguments;
         new_function->locals = fptr->locals;
+        new_function->shrink_wrap = fptr->shrink_wrap;
 
         /*
         Copy over the instructions.
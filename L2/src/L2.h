@@ -9,17 +9,39 @@
 #include <list>
 #include <map>
 #include <tuple>
-
+#include <atomic>
+#include <mutex>
+
+#include "arena.h"
+#include "analysis_tables.h"
+#include "control_flow.h"
+#include "allocation_report.h"
+#include "phase_timing.h"
 #include "variable_allocator.h"
+#include "bit_vector.h"
 #include "interference_graph.h"
 #include "liveness_analysis.h"
 #include "graph_coloring.h"
+#include "register_coalescing.h"
+#include "pbqp_allocation.h"
+#include "linear_scan.h"
+#include "stack_slots.h"
 #include "spill.h"
+#include "spill_cost.h"
+#include "shrink_wrapping.h"
+#include "incremental_analysis.h"
 
 namespace L2 {
 
   extern int const debug;
 
+  /*
+  Functions can be allocated on several threads (-j), so the runtime debug switch is atomic and the multi-line dumps
+  it enables (liveness sets, graphs, whole functions) are written while holding debug_output.
+  */
+  extern std::atomic<int> printdebug;
+  extern std::mutex debug_output;
+
   // Forward declarations
   class Function;
   class Program;
@@ -34,17 +56,60 @@ namespace L2 {
   Code Analysis.
   */
   Graph* analyze_L2(Function*);
+  Graph* analyze_L2(Function*, Curr_F_Liveness&);    // also hands back the liveness, for update_analysis_after_spill
   
   /*
   Register Allocation.
+  - optLevel >= 2 colors with iterated register coalescing, -O0/-O1 use linear scan (falling back to the plain
+    simplify/select coloring if linear scan gets stuck).
+  */
+  Function* allocate_registers(Function*, int32_t optLevel);
+
+  /*
+  Kind tags, fixed when an Item or Instruction is built, so hot loops can switch on them instead of trying one
+  dynamic_cast after the other. The Visitor stays the interface for everything else.
   */
-  Function* allocate_registers(Function*);
+  enum class ItemKind : uint8_t {
+    variable,
+    reg,
+    number,
+    name,
+    label,
+    op
+  };
+
+  enum class InstructionKind : uint8_t {
+    ret,
+    assignment,
+    stackarg,
+    label,
+    goto_label,
+    call_tenserr,
+    call_uN,
+    call_print,
+    call_input,
+    call_allocate,
+    call_tuple,
+    increment_decrement,
+    atreg,
+    memory_store,
+    memory_load,
+    memory_arithmetic_load,
+    memory_arithmetic_store,
+    cmp,
+    cjump,
+    aop,
+    sop
+  };
 
   /*
   Object Classes
   */
-  class Item {
+  class Item : public ArenaAllocated<Item> {
     public:
+      Item(ItemKind kind) : kind(kind) {}
+      Item& operator=(const Item &) { return *this; }    // an Item keeps its kind when a value is copied over it
+      const ItemKind kind;
       virtual std::string translate() = 0;    // returns string with the x86 conventions attached
       virtual std::string print() = 0;        // returns the value as is
       virtual Item* clone() const = 0; // Pure virtual clone method
@@ -57,6 +122,8 @@ namespace L2 {
       virtual std::string print() override;
       std::string name;
       Item* clone() const override;
+    protected:
+      Variable (std::string name, ItemKind kind);
 
   };
   class Register : public Variable {
@@ -115,17 +182,15 @@ namespace L2 {
   /*
    * Instruction interface.
    */
-  class Instruction{
+  class Instruction : public ArenaAllocated<Instruction> {
     public:
+      Instruction(InstructionKind kind) : kind(kind) {}
+      virtual ~Instruction() {}
+      const InstructionKind kind;
       virtual void accept(Visitor *visitor) = 0; 
-      virtual void gen(Function *f, std::ofstream &outputFile) = 0;
+      virtual void gen(Function *f, std::ostream &outputFile) = 0;
       virtual void spill_gen(Function *f, std::ofstream &outputFile) = 0;
       virtual void printMe() = 0;
-
-      std::set<Instruction *> predecessors;
-      std::set<Instruction *> successors;
-      std::set<Variable *> used; //all variables being read (right side of the operand)
-      std::set<Variable *> defined; //all variables being written (left side of the operand )
   };
 
   /*
@@ -134,7 +199,7 @@ namespace L2 {
   class Instruction_ret : public Instruction{
     public:
       Instruction_ret ();
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -143,7 +208,7 @@ namespace L2 {
   class Instruction_assignment : public Instruction{
     public:
       Instruction_assignment (Item *d, Item *s);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -154,7 +219,7 @@ namespace L2 {
     public:
       stackarg_assignment(Item *w, Item *M);
       void accept(Visitor *visitor) override;
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void insert(Function *f, std::ofstream &outputFile, int i);
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
@@ -168,21 +233,22 @@ namespace L2 {
     public:
       label_Instruction(Item *label);
       void accept(Visitor *visitor) override;
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       std::string getLabel() {
-          Label *labelPtr = dynamic_cast<Label*>(label);
-          return labelPtr->getLabel();
+          return label->print();
       }
       Item *label; 
+    protected:
+      label_Instruction(Item *label, InstructionKind kind);
   };
 
   class goto_label_instruction : public label_Instruction {
     public:
       void accept(Visitor *visitor) override;
       goto_label_instruction(Item *label);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
   };
@@ -191,7 +257,7 @@ namespace L2 {
     public:
       void accept(Visitor *visitor) override;
       Call_tenserr_Instruction(Item *F);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       Item *F;
@@ -200,7 +266,7 @@ namespace L2 {
   class Call_uN_Instruction : public Instruction {
     public:
       Call_uN_Instruction(Item *u, Item *N);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -212,7 +278,7 @@ namespace L2 {
     public:
       void accept(Visitor *visitor) override;
       Call_print_Instruction();
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
   };
@@ -221,7 +287,7 @@ namespace L2 {
     public:
       Call_input_Instruction();
       void accept(Visitor *visitor) override;
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
   };
@@ -230,7 +296,7 @@ namespace L2 {
     public:
       Call_allocate_Instruction();
       void accept(Visitor *visitor) override;
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
   };
@@ -239,7 +305,7 @@ namespace L2 {
     public:
       Call_tuple_Instruction();
       void accept(Visitor *visitor) override;
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
   };
@@ -247,7 +313,7 @@ namespace L2 {
   class w_increment_decrement : public Instruction {
     public:
       w_increment_decrement(Item *r, Item *symbol);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -259,7 +325,7 @@ namespace L2 {
     // w1 @ w2 w3 E   
     public:
       w_atreg_assignment(Item *r1, Item *r2, Item *r3, Item *E);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -272,7 +338,7 @@ namespace L2 {
   class Memory_assignment_store : public Instruction {
     public:
       Memory_assignment_store(Item *dst, Item *s, Item *M);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -285,7 +351,7 @@ namespace L2 {
   class Memory_assignment_load : public Instruction {
     public:
       Memory_assignment_load(Item *dst, Item *x, Item *M);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -297,7 +363,7 @@ namespace L2 {
   class Memory_arithmetic_load : public Instruction {
     public:
       Memory_arithmetic_load(Item *dst, Item *x, Item *instruction, Item *M);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -310,7 +376,7 @@ namespace L2 {
   class Memory_arithmetic_store : public Instruction {
     public:
       Memory_arithmetic_store(Item *dst, Item *t, Item *instruction, Item *M);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -324,7 +390,7 @@ namespace L2 {
     // w <- t2 cmp t1
     public:
       cmp_Instruction(Item *dst, Item *t2, Item *method, Item *t1);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -337,7 +403,7 @@ namespace L2 {
   class cjump_cmp_Instruction : public Instruction {
     public:
       cjump_cmp_Instruction(Item *t2, Item *cmp, Item *t1, Item *label);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -358,7 +424,7 @@ namespace L2 {
   //   public:
   //     stackarg_assignment(Item *w,Item *op, Item *M);
   //     virtual void accept(Visitor *visitor) = 0; // Accept a visitor
-  //     void gen(Function *f, std::ofstream &outputFile) override;
+  //     void gen(Function *f, std::ostream &outputFile) override;
   //     void printMe() override;
   //     Item *w;
   //     Item *op;
@@ -367,7 +433,7 @@ namespace L2 {
   class AOP_assignment : public Instruction {
     public:
       AOP_assignment(Item *method, Item *dst, Item *src);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -379,7 +445,7 @@ namespace L2 {
   class SOP_assignment : public Instruction {
     public:
       SOP_assignment(Item *method, Item *dst, Item *src);
-      void gen(Function *f, std::ofstream &outputFile) override;
+      void gen(Function *f, std::ostream &outputFile) override;
       void spill_gen(Function *f, std::ofstream &outputFile) override;
       void printMe() override;
       void accept(Visitor *visitor) override;
@@ -388,12 +454,60 @@ namespace L2 {
       Item *src;
   };
   
+  /*
+  Tag based stand-ins for dynamic_cast, for the hot loops. They answer exactly as dynamic_cast would: a Register is
+  also a Variable, and null comes back for anything else (or a null item).
+  */
+  inline Variable* as_variable(Item *item) {
+    return (item && (item->kind == ItemKind::variable || item->kind == ItemKind::reg)) ? static_cast<Variable*>(item) : nullptr;
+  }
+  inline Register* as_register(Item *item) {
+    return (item && item->kind == ItemKind::reg) ? static_cast<Register*>(item) : nullptr;
+  }
+  inline Number* as_number(Item *item) {
+    return (item && item->kind == ItemKind::number) ? static_cast<Number*>(item) : nullptr;
+  }
+  inline Label* as_label(Item *item) {
+    return (item && item->kind == ItemKind::label) ? static_cast<Label*>(item) : nullptr;
+  }
+
+  /*
+  Calls of any kind, the runtime ones included.
+  */
+  inline bool is_call(Instruction *iptr) {
+    switch (iptr->kind) {
+      case InstructionKind::call_uN:
+      case InstructionKind::call_print:
+      case InstructionKind::call_input:
+      case InstructionKind::call_allocate:
+      case InstructionKind::call_tuple:
+      case InstructionKind::call_tenserr:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  /*
+  The label a jump goes to ("goto" and "cjump"), null for every other instruction.
+  */
+  inline Item* jump_target(Instruction *iptr) {
+    switch (iptr->kind) {
+      case InstructionKind::goto_label:
+        return static_cast<goto_label_instruction*>(iptr)->label;
+      case InstructionKind::cjump:
+        return static_cast<cjump_cmp_Instruction*>(iptr)->label;
+      default:
+        return nullptr;
+    }
+  }
+
 // OUR OWN FUNCTIONs
 
   /*
    * Function.
    */
-  class Function{
+  class Function : public ArenaAllocated<Function> {
     public:
       std::string name;
       int64_t arguments;
@@ -403,8 +517,18 @@ namespace L2 {
       std::set<Variable *> spilled_variables; // for original variables in the L2 program that need to be spilled
       std::set<Variable *> spill_variables_set;   // for our custom variables that we replace spilled variables with
       std::set<std::string> string_spill_variables_set;
+      InstructionTables tables;     // use/def sets and CFG edges, indexed by instruction position
+      AllocationStats stats;        // filled in by allocate_registers
+      bool shrink_wrap = false;     // callee-saved registers are allocatable, shrink_wrap_callee_saves saves them
       void calculateCFG();
       void calculateUseDefs();
+      const ControlFlowGraph& control_flow();   // basic blocks, dominators and loops, built on first use
+      void invalidate_analysis();   // call after rewriting instructions
+      void invalidate_control_flow();   // same, for a rewrite that has brought the use/def tables up to date itself
+      void release_code();          // drops instructions, variables and analysis, name and stats stay
+
+    private:
+      ControlFlowGraph control_flow_graph;
   }; 
 
   class Program{
@@ -441,8 +565,13 @@ namespace L2 {
       virtual void visit(AOP_assignment *instruction) = 0;
       virtual void visit(SOP_assignment *instruction) = 0;
   };
+  /*
+  Fills in the used/defined lists of one instruction; point used and defined at its entries in the tables first.
+  */
   class UseDefVisitor: public Visitor {
     public:
+      OperandList *used = nullptr;
+      OperandList *defined = nullptr;
       // void visit(Function function) override;
       // void visit(Instruction *instruction) override;
       void visit(Instruction_ret *instruction) override;
@@ -501,6 +630,36 @@ namespace L2 {
       bool spilledLHS;
       bool spilledRHS; 
   };
+  /*
+  Renames spilled variables in place for spill_variables: every operand named after a key of replacements becomes
+  the mapped %S temporary.
+  */
+  class SpillRewriteVisitor: public Visitor {
+    public:
+      void rename(Item*& item);
+      void visit(Instruction_ret *instruction) override;
+      void visit(Instruction_assignment *instruction) override;
+      void visit(label_Instruction *instruction) override;
+      void visit(goto_label_instruction *instruction) override;
+      void visit(Call_tenserr_Instruction *instruction) override;
+      void visit(Call_uN_Instruction *instruction) override;
+      void visit(Call_print_Instruction *instruction) override;
+      void visit(Call_input_Instruction *instruction) override;
+      void visit(Call_allocate_Instruction *instruction) override;
+      void visit(Call_tuple_Instruction *instruction) override;
+      void visit(w_increment_decrement *instruction) override;
+      void visit(w_atreg_assignment *instruction) override;
+      void visit(Memory_assignment_store *instruction) override;
+      void visit(Memory_assignment_load *instruction) override;
+      void visit(Memory_arithmetic_load *instruction) override;
+      void visit(Memory_arithmetic_store *instruction) override;
+      void visit(cmp_Instruction *instruction) override;
+      void visit(cjump_cmp_Instruction *instruction) override;
+      void visit(stackarg_assignment *instruction) override;
+      void visit(AOP_assignment *instruction) override;
+      void visit(SOP_assignment *instruction) override;
+      std::unordered_map<std::string, Variable*> replacements;
+  };
   class ColorVariablesVisitor: public Visitor {
     public:
       ColorVariablesVisitor(Graph *graph, Function *func) :
@@ -582,41 +741,30 @@ namespace L2 {
   };
 
   /*
-  Liveness Analysis Storage Classes
+  Liveness results for a single function.
+  - variables holds every variable/register the function touches, indexed by its dense id.
+  - gen/kill and in()/out() are indexed by instruction position in the function.
+  - the solver only computes In/Out per basic block; in() and out() expand a block into
+    per-instruction sets the first time one of its instructions is asked for.
   */
-  enum SetType {
-    in,
-    out,
-    gen,
-    kill
-  };
-
-  class In_Out_Store {
-    public:
-      In_Out_Store(Program *p);
-      void print_sets(int function_index, Instruction* instruction_ptr);
-      std::vector<std::unordered_map<Instruction*, std::set<Variable*>>> In_Set;
-      std::vector<std::unordered_map<Instruction*, std::set<Variable*>>> Out_Set;
-  };
-
-  class Gen_Kill_Store {
-    public:
-      Gen_Kill_Store(Program *p);
-      void print_sets(int function_index, Instruction* instruction_ptr);
-      std::vector<std::unordered_map<Instruction*, std::set<Variable*>>> Gen_Set;
-      std::vector<std::unordered_map<Instruction*, std::set<Variable*>>> Kill_Set;
-  };
-
-  struct LivenessResult {
-    Gen_Kill_Store gen_kill_sets;
-    In_Out_Store in_out_sets;
-  };
-
   struct Curr_F_Liveness {
-    std::unordered_map<Instruction*, std::set<Variable*>> gen;
-    std::unordered_map<Instruction*, std::set<Variable*>> kill;
-    std::unordered_map<Instruction*, std::set<Variable*>> in;
-    std::unordered_map<Instruction*, std::set<Variable*>> out;
+    std::vector<Variable*> variables;
+    std::unordered_map<Variable*, int> variable_ids;
+    std::vector<BitVector> gen;
+    std::vector<BitVector> kill;
+    const BitVector& in(int64_t instruction_index);
+    const BitVector& out(int64_t instruction_index);
+
+    std::vector<int64_t> block_of;      // instruction position -> block
+    std::vector<int64_t> block_first;   // block -> position of its first instruction
+    std::vector<int64_t> block_last;    // block -> position of its last instruction
+    std::vector<BitVector> block_in;
+    std::vector<BitVector> block_out;
+
+    void expand_block(int64_t block);
+    std::vector<BitVector> instruction_in;
+    std::vector<BitVector> instruction_out;
+    std::vector<bool> block_expanded;
   };
 
   /*
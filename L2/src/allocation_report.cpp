@@ -0,0 +1,46 @@
+#include <iomanip>
+
+#include "L2.h"
+#include "allocation_report.h"
+
+using namespace std;
+
+namespace L2 {
+
+    void finish_allocation_stats(Function *fptr) {
+      fptr->stats.moves = 0;
+      for (auto iptr : fptr->instructions) {
+        if (iptr->kind != InstructionKind::assignment) continue;
+        auto assignment = static_cast<Instruction_assignment*>(iptr);
+        if (as_variable(assignment->d) && as_variable(assignment->s)) fptr->stats.moves++;
+      }
+      fptr->stats.frame_size = (int64_t)fptr->locals * 8;
+    }
+
+    void print_allocation_report(std::ostream &out, const std::vector<Function*> &functions, int64_t peak_rss_kb) {
+      out << "{\"peak_rss_kb\": " << peak_rss_kb << ", \"functions\": [" << std::endl;
+      for (size_t i = 0; i < functions.size(); i++) {
+        const AllocationStats &stats = functions[i]->stats;
+        out << "{\"name\": \"" << functions[i]->name << "\""
+            << ", \"allocator\": \"" << stats.allocator << "\""
+            << ", \"instructions\": " << stats.instructions
+            << ", \"spilled_variables\": " << stats.spilled_variables
+            << ", \"rematerialized\": " << stats.rematerialized
+            << ", \"spill_loads\": " << stats.spill_loads
+            << ", \"spill_stores\": " << stats.spill_stores
+            << ", \"moves\": " << stats.moves
+            << ", \"frame_size\": " << stats.frame_size
+            << ", \"coloring_iterations\": " << stats.coloring_iterations
+            << ", \"callee_saves\": " << stats.callee_saves
+            << std::fixed << std::setprecision(3)
+            << ", \"allocation_ms\": " << stats.allocation_ms
+            << ", \"liveness_ms\": " << stats.liveness_ms
+            << ", \"graph_ms\": " << stats.graph_ms
+            << ", \"coloring_ms\": " << stats.coloring_ms
+            << ", \"spill_ms\": " << stats.spill_ms << "}"
+            << (i + 1 < functions.size() ? "," : "") << std::endl;
+      }
+      out << "]}" << std::endl;
+    }
+
+}
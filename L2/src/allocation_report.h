@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace L2 {
+
+    class Function;
+
+    /*
+    What register allocation did to one function, for the -r report.
+    - the passes that do the work count it on Function::stats as they go; the spill loads and stores are the ones
+      left in the final code (inserted by spill_variables minus the ones reuse_spill_reloads removed).
+    */
+    struct AllocationStats {
+        std::string allocator;              // linear scan, coloring, coalescing or pbqp
+        int64_t instructions = 0;           // before allocation
+        int64_t spilled_variables = 0;      // over all spill rounds, rematerialized ones included
+        int64_t rematerialized = 0;
+        int64_t spill_loads = 0;
+        int64_t spill_stores = 0;
+        int64_t moves = 0;                  // register to register moves left after coalescing
+        int64_t frame_size = 0;             // bytes of stack slots
+        int64_t coloring_iterations = 0;    // coloring (or linear scan) attempts, one per spill round
+        int64_t callee_saves = 0;           // callee-saved registers shrink_wrap_callee_saves saves
+        double allocation_ms = 0;
+        double liveness_ms = 0;             // the phases of allocation_ms (PhaseScope), over all rounds; a phase
+                                            // includes the ones it runs, as a spill round its liveness
+        double graph_ms = 0;                // interference graph and spill costs
+        double coloring_ms = 0;             // coloring, or linear scan
+        double spill_ms = 0;                // spill rewriting and patching the analysis after it
+    };
+
+    /*
+    Moves and frame size of the allocated function; call once allocation is done.
+    */
+    void finish_allocation_stats(Function *fptr);
+
+    /*
+    The report as a JSON object: the peak memory of the whole compilation, then one entry per function in program
+    order, each on its own line so line based tools (L2/scripts/allocatorReport.sh) can read it too.
+    */
+    void print_allocation_report(std::ostream &out, const std::vector<Function*> &functions, int64_t peak_rss_kb);
+
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "analysis_tables.h"
+
+using namespace std;
+
+namespace L2 {
+
+    /*
+    Fresh, empty operand lists for count instructions, ready for the use/def visitor to fill.
+    */
+    void InstructionTables::set_use_defs(size_t count) {
+      used.assign(count, OperandList());
+      defined.assign(count, OperandList());
+      use_defs_valid = true;
+    }
+
+    /*
+    Build both compressed edge arrays from a list of (from, to) position pairs, which may hold duplicates.
+    */
+    void InstructionTables::set_cfg(size_t count, std::vector<std::pair<int64_t, int64_t>> &edges) {
+      std::sort(edges.begin(), edges.end());
+      edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+      successor_start.assign(count + 1, 0);
+      predecessor_start.assign(count + 1, 0);
+      for (auto& edge : edges) {
+        successor_start[edge.first + 1]++;
+        predecessor_start[edge.second + 1]++;
+      }
+      for (size_t i = 0; i < count; i++) {
+        successor_start[i + 1] += successor_start[i];
+        predecessor_start[i + 1] += predecessor_start[i];
+      }
+
+      /*
+      The edges are sorted by source, so the successor lists come out in order; the predecessor lists are filled
+      in the same pass and end up sorted too.
+      */
+      successor_list.resize(edges.size());
+      predecessor_list.resize(edges.size());
+      std::vector<int64_t> predecessor_next(predecessor_start.begin(), predecessor_start.end() - 1);
+      for (size_t k = 0; k < edges.size(); k++) {
+        successor_list[k] = edges[k].second;
+        predecessor_list[predecessor_next[edges[k].second]++] = edges[k].first;
+      }
+      cfg_valid = true;
+    }
+
+    void InstructionTables::invalidate() {
+      used.clear();
+      defined.clear();
+      successor_start.clear();
+      successor_list.clear();
+      predecessor_start.clear();
+      predecessor_list.clear();
+      use_defs_valid = false;
+      cfg_valid = false;
+    }
+
+    void InstructionTables::invalidate_cfg() {
+      successor_start.clear();
+      successor_list.clear();
+      predecessor_start.clear();
+      predecessor_list.clear();
+      cfg_valid = false;
+    }
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace L2 {
+
+    class Variable;
+
+    /*
+    The variables one instruction reads or writes, stored inline: an L2 instruction names at most three, so a
+    fixed array beats a std::set node per variable.
+    - insert ignores null and duplicates, like the sets it replaces; iteration is in insertion order.
+    */
+    class OperandList {
+        public:
+            static const int capacity = 4;
+
+            void insert(Variable *var) {
+                if (!var || count(var)) return;
+                assert(length < capacity);
+                operands[length++] = var;
+            }
+            bool count(Variable *var) const {
+                for (int k = 0; k < length; k++) {
+                    if (operands[k] == var) return true;
+                }
+                return false;
+            }
+            Variable* const* begin() const { return operands; }
+            Variable* const* end() const { return operands + length; }
+            int size() const { return length; }
+            bool empty() const { return length == 0; }
+
+        private:
+            Variable *operands[capacity];
+            int8_t length = 0;
+    };
+
+    /*
+    Read-only view of a run of instruction positions (one instruction's successors or predecessors).
+    */
+    struct PositionRange {
+        const int64_t *first;
+        const int64_t *last;
+        const int64_t* begin() const { return first; }
+        const int64_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        int64_t operator[](size_t k) const { return first[k]; }
+    };
+
+    /*
+    Per-instruction analysis state of a function, kept as a struct of arrays indexed by instruction position
+    instead of inside the Instruction objects.
+    - used/defined are filled by Function::calculateUseDefs, the CFG edges by Function::calculateCFG; both
+      describe the instruction vector as it was when they ran.
+    - the edges are stored compressed: the successors of position i are successor_list[successor_start[i] ..
+      successor_start[i + 1]), sorted and without duplicates; same for the predecessors.
+    - a pass that rewrites the instruction vector calls Function::invalidate_analysis; reading a table that is
+      not valid (or was built for a different instruction count) trips an assert. spill_variables patches the
+      use/def tables as it rewrites and only drops the edges (Function::invalidate_control_flow).
+    */
+    struct InstructionTables {
+        std::vector<OperandList> used;      // variables read by the instruction
+        std::vector<OperandList> defined;   // variables written by the instruction
+        std::vector<int64_t> successor_start;
+        std::vector<int64_t> successor_list;
+        std::vector<int64_t> predecessor_start;
+        std::vector<int64_t> predecessor_list;
+        bool use_defs_valid = false;
+        bool cfg_valid = false;
+
+        void set_use_defs(size_t count);
+        void set_cfg(size_t count, std::vector<std::pair<int64_t, int64_t>> &edges);
+        void invalidate();
+        void invalidate_cfg();              // the use/def tables stay
+
+        const OperandList& uses(int64_t i) const {
+            assert(use_defs_valid && (size_t)i < used.size());
+            return used[i];
+        }
+        const OperandList& defs(int64_t i) const {
+            assert(use_defs_valid && (size_t)i < defined.size());
+            return defined[i];
+        }
+        PositionRange successors(int64_t i) const {
+            assert(cfg_valid && (size_t)i + 1 < successor_start.size());
+            return {successor_list.data() + successor_start[i], successor_list.data() + successor_start[i + 1]};
+        }
+        PositionRange predecessors(int64_t i) const {
+            assert(cfg_valid && (size_t)i + 1 < predecessor_start.size());
+            return {predecessor_list.data() + predecessor_start[i], predecessor_list.data() + predecessor_start[i + 1]};
+        }
+    };
+
+}
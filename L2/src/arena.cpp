@@ -0,0 +1,104 @@
+#include <new>
+
+#include "arena.h"
+
+using namespace std;
+
+namespace L2 {
+
+    static thread_local Arena *current_arena = nullptr;
+
+    Arena::Arena(size_t chunk_size) : chunk_size(chunk_size) {}
+
+    Arena::~Arena() {
+      release();
+      for (auto chunk : chunks) ::operator delete(chunk);
+    }
+
+    void* Arena::allocate(size_t size, void (*destroy)(void*)) {
+      size_t needed = header_size + (size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+      /*
+      Objects bigger than a chunk get a block of their own, the current chunk stays in use.
+      */
+      if (needed > chunk_size) {
+        char *block = static_cast<char*>(::operator new(needed));
+        large_blocks.push_back(block);
+        return place(block, needed, destroy);
+      }
+      if ((size_t)(end - next) < needed) {
+        char *chunk = static_cast<char*>(::operator new(chunk_size));
+        chunks.push_back(chunk);
+        next = chunk;
+        end = chunk + chunk_size;
+      }
+      char *memory = next;
+      next += needed;
+      return place(memory, needed, destroy);
+    }
+
+    void* Arena::place(char *memory, size_t needed, void (*destroy)(void*)) {
+      Header *header = reinterpret_cast<Header*>(memory);
+      header->arena = this;
+      header->finalizer = finalizers.size();
+      void *object = memory + header_size;
+      finalizers.push_back({object, destroy});
+      allocated += needed;
+      return object;
+    }
+
+    /*
+    Destructors first, newest object first, while every chunk is still there: an object may look at another one
+    in the same arena while it is destroyed. The first chunk is kept for the next function.
+    */
+    void Arena::release() {
+      for (auto it = finalizers.rbegin(); it != finalizers.rend(); it++) {
+        if (it->second) it->second(it->first);
+      }
+      finalizers.clear();
+      for (auto block : large_blocks) ::operator delete(block);
+      large_blocks.clear();
+      for (size_t c = 1; c < chunks.size(); c++) ::operator delete(chunks[c]);
+      if (chunks.size() > 1) chunks.resize(1);
+      next = chunks.empty() ? nullptr : chunks[0];
+      end = chunks.empty() ? nullptr : chunks[0] + chunk_size;
+      allocated = 0;
+    }
+
+    size_t Arena::bytes() const {
+      return allocated;
+    }
+
+    void* Arena::allocate_object(size_t size, void (*destroy)(void*)) {
+      if (current_arena) return current_arena->allocate(size, destroy);
+      char *memory = static_cast<char*>(::operator new(header_size + size));
+      Header *header = reinterpret_cast<Header*>(memory);
+      header->arena = nullptr;
+      header->finalizer = 0;
+      return memory + header_size;
+    }
+
+    void Arena::free_object(void *object) {
+      if (!object) return;
+      char *memory = static_cast<char*>(object) - header_size;
+      Header *header = reinterpret_cast<Header*>(memory);
+      if (!header->arena) {
+        ::operator delete(memory);
+        return;
+      }
+      header->arena->finalizers[header->finalizer].second = nullptr;
+    }
+
+    Arena* Arena::current() {
+      return current_arena;
+    }
+
+    ArenaScope::ArenaScope(Arena *arena) : previous(current_arena) {
+      current_arena = arena;
+    }
+
+    ArenaScope::~ArenaScope() {
+      current_arena = previous;
+    }
+
+}
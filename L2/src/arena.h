@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace L2 {
+
+    /*
+    Bump pointer arena that owns IR, graph and analysis objects and frees them all at once.
+    - objects are carved out of large chunks; releasing the arena runs their destructors (newest first) and
+      hands the chunks back, so nothing allocated in it may be used after that.
+    - the compiler keeps one arena for the whole compilation (the parsed program) and one per function being
+      allocated, released as soon as that function's L1 code is written.
+    - "delete" on an arena object runs its destructor right away; its memory only comes back with the arena.
+    */
+    class Arena {
+        public:
+            Arena(size_t chunk_size = 64 * 1024);
+            ~Arena();
+            void* allocate(size_t size, void (*destroy)(void*));
+            void release();
+            size_t bytes() const;       // bytes handed out since the last release
+
+            /*
+            Allocation entry points used by ArenaAllocated: the arena of the innermost ArenaScope on this thread,
+            the heap when there is none.
+            */
+            static void* allocate_object(size_t size, void (*destroy)(void*));
+            static void free_object(void *object);
+            static Arena* current();    // null when there is no ArenaScope on this thread
+
+        private:
+            struct Header {
+                Arena *arena;           // null for heap objects
+                size_t finalizer;       // index into finalizers
+            };
+            void* place(char *memory, size_t needed, void (*destroy)(void*));
+
+            static const size_t header_size = (sizeof(Header) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+            size_t chunk_size;
+            std::vector<char*> chunks;
+            std::vector<char*> large_blocks;
+            char *next = nullptr;
+            char *end = nullptr;
+            size_t allocated = 0;
+            std::vector<std::pair<void*, void (*)(void*)>> finalizers;
+    };
+
+    /*
+    Makes an arena the one that "new" of arena allocated classes uses on this thread, until the scope ends.
+    Scopes nest; each thread starts without one.
+    */
+    class ArenaScope {
+        public:
+            ArenaScope(Arena *arena);
+            ~ArenaScope();
+
+        private:
+            Arena *previous;
+    };
+
+    /*
+    Base for the classes that live in arenas (Item, Instruction, Function, Node, Graph): their plain "new" goes to
+    the current arena. T must be the class that derives from it, and T's destructor must be virtual if subclasses
+    of T are allocated.
+    */
+    template <typename T>
+    class ArenaAllocated {
+        public:
+            static void* operator new(size_t size) {
+                return Arena::allocate_object(size, &destroy);
+            }
+            static void operator delete(void *object) {
+                Arena::free_object(object);
+            }
+
+        private:
+            static void destroy(void *object) {
+                static_cast<T*>(object)->~T();
+            }
+    };
+
+}
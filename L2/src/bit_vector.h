@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace L2 {
+
+    /*
+    Fixed-width bit vector used by the dataflow analyses.
+    - Each variable/register of a function gets a dense id (see Curr_F_Liveness), and that id is its bit.
+    - Every set operation walks whole 64-bit words in a flat loop so the compiler can vectorize it.
+    */
+    class BitVector {
+        public:
+            BitVector() {}
+            BitVector(size_t bits) : bits(bits), words((bits + 63) / 64, 0) {}
+
+            void set(size_t i) {
+                words[i >> 6] |= (uint64_t)1 << (i & 63);
+            }
+            void reset(size_t i) {
+                words[i >> 6] &= ~((uint64_t)1 << (i & 63));
+            }
+            bool test(size_t i) const {
+                return (words[i >> 6] >> (i & 63)) & 1;
+            }
+            void clear() {
+                for (auto& w : words) w = 0;
+            }
+            size_t size() const {
+                return bits;
+            }
+
+            /*
+            Widens the vector to new_bits, the added bits start out clear.
+            */
+            void grow(size_t new_bits) {
+                bits = new_bits;
+                words.resize((new_bits + 63) / 64, 0);
+            }
+
+            /*
+            this -= other, other may be narrower.
+            */
+            void subtract(const BitVector& other) {
+                size_t shared = std::min(words.size(), other.words.size());
+                for (size_t w = 0; w < shared; w++) {
+                    words[w] &= ~other.words[w];
+                }
+            }
+
+            /*
+            this |= other, returns true if any bit was added.
+            */
+            bool union_with(const BitVector& other) {
+                uint64_t added = 0;
+                for (size_t w = 0; w < words.size(); w++) {
+                    uint64_t merged = words[w] | other.words[w];
+                    added |= merged ^ words[w];
+                    words[w] = merged;
+                }
+                return added != 0;
+            }
+
+            /*
+            this = gen U (out - kill), the liveness transfer function. Returns true if this changed.
+            */
+            bool assign_transfer(const BitVector& gen, const BitVector& out, const BitVector& kill) {
+                uint64_t changed = 0;
+                for (size_t w = 0; w < words.size(); w++) {
+                    uint64_t result = gen.words[w] | (out.words[w] & ~kill.words[w]);
+                    changed |= result ^ words[w];
+                    words[w] = result;
+                }
+                return changed != 0;
+            }
+
+            bool operator==(const BitVector& other) const {
+                return words == other.words;
+            }
+            bool operator!=(const BitVector& other) const {
+                return words != other.words;
+            }
+
+            /*
+            Calls f(id) for every set bit, in increasing id order.
+            */
+            template <typename F>
+            void for_each(F f) const {
+                for (size_t w = 0; w < words.size(); w++) {
+                    uint64_t word = words[w];
+                    while (word) {
+                        f(w * 64 + __builtin_ctzll(word));
+                        word &= word - 1;
+                    }
+                }
+            }
+
+            size_t count() const {
+                size_t n = 0;
+                for (auto w : words) n += __builtin_popcountll(w);
+                return n;
+            }
+
+            size_t bits = 0;
+            std::vector<uint64_t> words;
+    };
+
+}
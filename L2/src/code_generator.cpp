@@ -1,6 +1,7 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include "L2.h"
 #include <code_generator.h>
 
@@ -34,92 +35,92 @@ namespace L2{
         "rbx"
     };
   
-  void Instruction_ret::gen(Function *f, std::ofstream &outputFile) {
+  void Instruction_ret::gen(Function *f, std::ostream &outputFile) {
     outputFile << "return\n\t";
   }
 
-  void Instruction_assignment::gen(Function *f, std::ofstream &outputFile) {
+  void Instruction_assignment::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->d->print() << " <- " << this->s->print() << "\n\t";
   }
 
-  void label_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void label_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->label->print()<<"\n\t";
   }
 
-  void goto_label_instruction::gen(Function *f, std::ofstream &outputFile) {
+  void goto_label_instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "goto " << this->label->print() << "\n\t";
   }
 
-  void Call_tenserr_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_tenserr_Instruction::gen(Function *f, std::ostream &outputFile) {
     if (debug) std::cerr << "gen method called for a Call_tenserr_instruction instance!" << std::endl;
     long long num = std::stoll(this->F->print());
     outputFile << "call tensor-error "<< this->F->print()<<"\n\t";
   }
 
-  void Call_uN_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_uN_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "call "<< this->u->print() << " "<< this->N->print()<<"\n\t";
   }
 
-  void Call_print_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_print_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "call print 1\n\t";
   }
 
-  void Call_input_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_input_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "call input 0\n\t";
   }
 
-  void Call_allocate_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_allocate_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "call allocate 2\n\t";
   }
 
-  void Call_tuple_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void Call_tuple_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << "call tuple-error 3\n\t";
   }
 
-  void w_increment_decrement::gen(Function *f, std::ofstream &outputFile) {
+  void w_increment_decrement::gen(Function *f, std::ostream &outputFile) {
     if (debug) std::cerr << "gen method called for a w_increment_decrement instance!" << std::endl;
     outputFile << this->r->print() << this->symbol->print() << "\n\t";
   }
 
-  void w_atreg_assignment::gen(Function *f, std::ofstream &outputFile) {
+  void w_atreg_assignment::gen(Function *f, std::ostream &outputFile) {
     // w1 @ w2 w3 E   
     outputFile << this->r1->print() << " @ "<<this->r2->print() <<" "<<this->r3->print()<<" "<<this->E->print()<<"\n\t";
   }
 
-  void Memory_assignment_store::gen(Function *f, std::ofstream &outputFile) {
+  void Memory_assignment_store::gen(Function *f, std::ostream &outputFile) {
     outputFile << "mem "<<this->dst->print()<<" "<<this->M->print()<<" <- "<<this->s->print()<<"\n\t";
   }
 
-  void Memory_assignment_load::gen(Function *f, std::ofstream &outputFile) {
+  void Memory_assignment_load::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->dst->print() <<" <- "<<"mem "<<this->x->print()<<" "<<this->M->print()<<"\n\t";
   }
 
-  void Memory_arithmetic_load::gen(Function *f, std::ofstream &outputFile) {
+  void Memory_arithmetic_load::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->dst->print()<<" "<< this->instruction->print()<<" mem "<<this->x->print()<<" "<<this->M->print()<<"\n\t";  
   }
 
-  void Memory_arithmetic_store::gen(Function *f, std::ofstream &outputFile) {
+  void Memory_arithmetic_store::gen(Function *f, std::ostream &outputFile) {
     outputFile << "mem "<<this->dst->print()<<" "<<this->M->print()<<" "<<this->instruction->print()<<" "<<this->t->print()<<"\n\t";
   }
 
-  void cmp_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void cmp_Instruction::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->dst->print()<<" <- "<<this->t2->print()<<" "<<this->method->print()<<" "<<this->t1->print()<<"\n\t";
   }
 
-  void cjump_cmp_Instruction::gen(Function *f, std::ofstream &outputFile) {
+  void cjump_cmp_Instruction::gen(Function *f, std::ostream &outputFile) {
     // cjump t2 cmp t1 label
     outputFile << "cjump "<<this->t2->print()<<" "<<this->cmp->print()<<" "<<this->t1->print()<<" "<<this->label->print()<<"\n\t";
   }
 
-  void AOP_assignment::gen(Function *f, std::ofstream &outputFile) {
+  void AOP_assignment::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->dst->print() << " "<<this->method->print()<<" "<<this->src->print()<<"\n\t";
   }
 
-  void SOP_assignment::gen(Function *f, std::ofstream &outputFile) {
+  void SOP_assignment::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->dst->print() << " "<<this->method->print()<<" "<<this->src->print()<<"\n\t";
   }
 
-  void stackarg_assignment::gen(Function *f, std::ofstream &outputFile) {
+  void stackarg_assignment::gen(Function *f, std::ostream &outputFile) {
     outputFile << this->w->print()<<" <- "<< "mem rsp "<<this->M->print()<<"\n\t";
   }
 
@@ -127,6 +128,18 @@ namespace L2{
   // void generate_code(Program p, Graph *color_graph) {
   // void generate_code(Program p, std::map<Function*, Graph*> all_graphs) {
   void generate_code(Program& p) {
+    std::vector<std::string> function_code;
+    for (Function *fptr : p.functions) {
+      std::ostringstream code;
+      generate_function_code(fptr, code);
+      function_code.push_back(code.str());
+    }
+    generate_code(p.entryPointLabel, function_code);
+  }
+
+  void generate_code(const std::string &entryPointLabel, const std::vector<std::string> &function_code) {
+    PhaseScope timer(Phase::code_generation);
+
     /* 
      * Open the output file.
      */ 
@@ -136,74 +149,9 @@ namespace L2{
     /*
     Gen the entry point label
     */
-    std::string entry_lab = p.entryPointLabel;
-    outputFile << "(" << entry_lab << "\n";
-
-    // main loop
-    for (Function *fptr : p.functions) {
-      /*
-      Grab the graph belonging to the current function
-      */
-      // Graph* color_graph;
-      // auto it = all_graphs.find(fptr);
-      // if (it != all_graphs.end()) {
-      //   color_graph = it->second;
-      // } else {
-      //   if (debug) std::cerr << "couldn't find a graph for the current function pointer\n";
-      // }
-      
-      std::string fname = fptr->name;
-
-      // std::cout << "Currently generating for function " << fname << std::endl;
-
-      outputFile << "(" << fname << "\n\t";
-
-      /*
-      theres some weird stuff going on with 'changed' why is everything inconsistent
-      just hardcode for now and remove the extra arg so we can at least compile
-      */
- 
- 
-      int stack_size = 0;
-      int stack_arg_size = 0;
-      std::unordered_map<int, bool> seen;
-      bool zero_seen = false;
-      // ColorVariablesVisitor* myColorVisitor = new ColorVariablesVisitor(color_graph,fptr);
-      for (Instruction *iptr : fptr->instructions) {
-        auto instruction = dynamic_cast<Memory_assignment_store*>(iptr);
-        if (instruction){
-          auto number = dynamic_cast<Number*>(instruction->M);
-          auto variable = dynamic_cast<Variable*>(instruction->s);
-          if (number->value >=0){
-            if (seen.find(number->value) == seen.end()) {
-              stack_arg_size++;
-              seen[number->value] = true;
-            }      
-            zero_seen = true;
-            if (number->value>stack_size){
-              stack_size = number->value;
-            }
-          }
-        }
-      }
-      int append = 0;
-      if (zero_seen == true){
-        append = (stack_size+1);
-      }
-    
-      //This might supposed to be stack_size here 
-
-      outputFile << fptr->arguments<<" "<<append<<"\n\t";
-      for (Instruction *iptr : fptr->instructions) {
-        // iptr->accept(myColorVisitor);
-        auto cast_stack_arg = dynamic_cast<stackarg_assignment*>(iptr);
-        if (cast_stack_arg){
-          outputFile << cast_stack_arg->w->print()<<" <- "<< "mem rsp "<<std::stoi(cast_stack_arg->M->print())+ (8*(append)) << "\n\t";
-        } else {
-          iptr->gen(fptr, outputFile);
-        }
-      }
-      outputFile<<")\n";
+    outputFile << "(" << entryPointLabel << "\n";
+    for (auto& code : function_code) {
+      outputFile << code;
     }
     outputFile << ")\n";
 
@@ -216,4 +164,27 @@ namespace L2{
    
     return ;
   }
+
+  void generate_function_code(Function *fptr, std::ostream &outputFile) {
+    PhaseScope timer(Phase::code_generation);
+    std::string fname = fptr->name;
+
+    outputFile << "(" << fname << "\n\t";
+
+    /*
+    The frame holds the stack slots handed out by allocate_stack_slots, stack arguments sit right above them.
+    */
+    int append = fptr->locals;
+
+    outputFile << fptr->arguments<<" "<<append<<"\n\t";
+    for (Instruction *iptr : fptr->instructions) {
+      if (iptr->kind == InstructionKind::stackarg){
+        auto cast_stack_arg = static_cast<stackarg_assignment*>(iptr);
+        outputFile << cast_stack_arg->w->print()<<" <- "<< "mem rsp "<<std::stoi(cast_stack_arg->M->print())+ (8*(append)) << "\n\t";
+      } else {
+        iptr->gen(fptr, outputFile);
+      }
+    }
+    outputFile<<")\n";
+  }
 }
@@ -8,4 +8,15 @@ namespace L2{
   // void generate_code(Program p, std::map<Function*, Graph*> all_graphs);
   void generate_code(Program& p);
 
+  /*
+  Writes prog.L1 from code generated one function at a time, in the given order, so each function can be dropped
+  as soon as its code is out.
+  */
+  void generate_code(const std::string &entryPointLabel, const std::vector<std::string> &function_code);
+
+  /*
+  The L1 code of one allocated function, "(@name ... )".
+  */
+  void generate_function_code(Function *fptr, std::ostream &outputFile);
+
 }
@@ -10,9 +10,12 @@
 #include <cstdlib>
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/resource.h>
 #include <iostream>
 #include <assert.h>
 #include <tuple>
+#include <sstream>
+#include <chrono>
 // #include "L2/src/parser.h"
 #include "parser.h"
 #include "liveness_analysis.h"
@@ -24,15 +27,13 @@
 #include "spill_code_generator.h"
 #include "L2.h"
 #include "spill.h"
-
-/*
-Debugging
-*/
-int printdebug = 0;
+#include "thread_pool.h"
+#include "lower_to_L1.h"
+#include <libL1.h>
 
 void print_help (char *progName){
   // std::cerr << "Usage: " << progName << " [-v] [-g 0|1] [-O 0|1|2] [-s] [-l] [-i] SOURCE" << std::endl;
-  std::cerr << "Usage: " << progName << " [-v] [-g 0|1] [-O 0|1|2] [-s] [-l] [-i] [-c] SOURCE" << std::endl;
+  std::cerr << "Usage: " << progName << " [-v] [-g 0|1] [-O 0|1|2|3] [-s] [-l] [-i] [-c] [-j N] [-r] [-T table|json] [-S] SOURCE" << std::endl;
   // ^ pass the argument c to run the graph coloring.
   return ;
 }
@@ -46,7 +47,12 @@ int main(
   auto interference_only = false;
   auto liveness_only = false;
   auto run_color = false; // extra debug
-  int32_t optLevel = 3;
+  int32_t optLevel = 2;    // -O3 (PBQP allocation) only on request, it trades compile time for code quality
+  int64_t jobs = 1;
+  auto report = false;
+  auto phase_report = false;
+  auto phase_report_json = false;
+  auto emit_assembly = false;
 
   /* 
    * Check the compiler arguments.
@@ -58,7 +64,7 @@ int main(
   }
   int32_t opt;
   int64_t functionNumber = -1;
-  while ((opt = getopt(argc, argv, "vg:O:slic")) != -1) {
+  while ((opt = getopt(argc, argv, "vg:O:slicj:rT:S")) != -1) {
     switch (opt){
 
       case 'l':
@@ -85,6 +91,23 @@ int main(
         verbose = true;
         break ;
 
+      case 'j':
+        jobs = strtol(optarg, NULL, 0);
+        break ;
+
+      case 'r':
+        report = true;
+        break ;
+
+      case 'T':
+        phase_report = true;
+        phase_report_json = (strcmp(optarg, "json") == 0);
+        break ;
+
+      case 'S':
+        emit_assembly = true;
+        break ;
+
       // our extra debug
       case 'c':
         run_color = true;
@@ -96,38 +119,54 @@ int main(
     }
   }
 
+  /*
+   * -T and -r are the only clients of the phase timers, they stay off (and cost a flag test) otherwise.
+   */
+  L2::phase_timing = phase_report;
+  L2::function_timing = report;
+  auto compilation_start = phase_report ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+  /*
+   * Everything that lives for the whole compilation (the parsed program) goes to this arena.
+   */
+  L2::Arena compilation_arena;
+  L2::ArenaScope compilation_scope(&compilation_arena);
+
   /*
    * Parse the input file.
    */
   L2::Program p;
-  if (spill_only){
-
-    /* 
-     * Parse an L2 function and the spill arguments.
-     */
-    p = L2::parse_spill_file(argv[optind]);
+  {
+    L2::PhaseScope parse_timer(L2::Phase::parse);
+    if (spill_only){
+
+      /* 
+       * Parse an L2 function and the spill arguments.
+       */
+      p = L2::parse_spill_file(argv[optind]);
  
-  } else if (liveness_only){
+    } else if (liveness_only){
 
-    /*
-     * Parse an L2 function.
-     */
-    p = L2::parse_function_file(argv[optind]);
+      /*
+       * Parse an L2 function.
+       */
+      p = L2::parse_function_file(argv[optind]);
     
-  } else if (interference_only || run_color){
+    } else if (interference_only || run_color){
 
-    /*
-     * Parse an L2 function.
-     */
-    p = L2::parse_function_file(argv[optind]);
+      /*
+       * Parse an L2 function.
+       */
+      p = L2::parse_function_file(argv[optind]);
 
-  } else {
+    } else {
 
-    /* 
-     * Parse the L2 program.
-     */
-    p = L2::parse_file(argv[optind]);
+      /* 
+       * Parse the L2 program.
+       */
+      p = L2::parse_file(argv[optind]);
 
+    }
   }
 
   /*
@@ -184,31 +223,90 @@ int main(
   }
 
   if (enable_code_generator) {
-    
-    /*
-    Initialize the output program that will be passed to the code generator.
-    */
-    L2::Program p_out;
-    p_out.entryPointLabel = p.entryPointLabel;
 
     /*
     Perform code analysis and variable allocation for each function in the original program.
-    Append the results to the output program.
+    Each function gets an arena of its own for everything the allocator creates; it is released as soon as the
+    function's L1 code has been generated, so memory stays bounded by the biggest function.
     */
-    while (!p.functions.empty()) {
-        L2::Function* fptr = p.functions.front();
+    std::vector<std::string> function_code(p.functions.size());
+    std::vector<L1::Function*> lowered_functions(p.functions.size());
+    auto compile_function = [&](size_t i) {
+      L2::Arena function_arena;
+      L2::ArenaScope function_scope(&function_arena);
+      auto start = report ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+      L2::Function* fptr_out = L2::allocate_registers(p.functions[i], optLevel);
+      if (report) fptr_out->stats.allocation_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (emit_assembly) {
+        lowered_functions[i] = L2::lower_function(fptr_out);
+      } else {
+        std::ostringstream code;
+        L2::generate_function_code(fptr_out, code);
+        function_code[i] = code.str();
+      }
+
+      /*
+      The instructions and variables the allocator left in the function live in function_arena. Drop them before
+      it goes away; the -r report only reads the name and the stats.
+      */
+      p.functions[i]->release_code();
+    };
+
+    if (jobs > 1) {
+
+        /*
+        -j N: functions share nothing but their place in the output, so allocate them concurrently.
+        The biggest functions are handed out first, the results are kept at their original index.
+        */
+        std::vector<size_t> order(p.functions.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+          return p.functions[a]->instructions.size() > p.functions[b]->instructions.size();
+        });
+        std::vector<std::function<void()>> allocations;
+        for (auto i : order) {
+          allocations.push_back([&, i]() {
+            compile_function(i);
+          });
+        }
+        L2::WorkStealingPool pool(jobs);
+        pool.run(allocations);
+    } else {
+        for (size_t i = 0; i < p.functions.size(); i++) {
+          compile_function(i);
+        }
+    }
 
-        p.functions.erase(p.functions.begin());
+    /*
+    Generate the L1 code.
+    -S: hand the lowered functions to the L1 library instead, which writes prog.S without an L1 file to parse.
+    */
+    if (emit_assembly) {
+      L2::PhaseScope code_generation_timer(L2::Phase::code_generation);
+      L1::Program lowered_program;
+      lowered_program.entryPointLabel = p.entryPointLabel;
+      lowered_program.functions = lowered_functions;
+      L1::generate_code(lowered_program, "prog.S");
+    } else {
+      L2::generate_code(p.entryPointLabel, function_code);
+    }
 
-        L2::Function* fptr_out = L2::allocate_registers(fptr);
-        
-        p_out.functions.push_back(fptr_out);
+    /*
+    -r: what the allocator did to every function, as JSON on stdout.
+    */
+    if (report) {
+      struct rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      L2::print_allocation_report(std::cout, p.functions, usage.ru_maxrss);
     }
 
     /*
-    Generate the L1 code.
+    -T: where the compilation's time went, per phase, on stderr.
     */
-    L2::generate_code(p_out);
+    if (phase_report) {
+      double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - compilation_start).count();
+      L2::print_phase_report(std::cerr, phase_report_json, total_ms);
+    }
 
     return 0;
   }
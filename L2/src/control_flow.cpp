@@ -0,0 +1,234 @@
+#include <unordered_map>
+
+#include "L2.h"
+#include "control_flow.h"
+
+using namespace std;
+
+namespace L2 {
+
+    void ControlFlowGraph::build(Function *fptr) {
+      PhaseScope timer(Phase::cfg);
+      clear();
+      find_blocks(fptr);
+      order_blocks();
+      find_dominators();
+      find_loops();
+      valid = true;
+      if (debug) std::cerr << fptr->name << ": " << block_count() << " blocks, " << rpo.size() << " reachable, "
+          << loops.size() << " loops" << std::endl;
+    }
+
+    void ControlFlowGraph::clear() {
+      block_first.clear();
+      block_last.clear();
+      block_of.clear();
+      successors.clear();
+      predecessors.clear();
+      rpo.clear();
+      rpo_index.clear();
+      idom.clear();
+      loops.clear();
+      loop_of.clear();
+      dominator_enter.clear();
+      dominator_exit.clear();
+      valid = false;
+    }
+
+    /*
+    Whether control can go from the instruction to the one after it.
+    */
+    static bool falls_through(Instruction *iptr) {
+      switch (iptr->kind) {
+        case InstructionKind::ret:
+        case InstructionKind::goto_label:
+        case InstructionKind::call_tenserr:
+        case InstructionKind::call_tuple:
+          return false;
+        default:
+          return true;
+      }
+    }
+
+    /*
+    One pass over the instructions cuts the blocks and records which block each label starts; a second pass over
+    the blocks links each one to its jump target (looked up by label) and to the block after it.
+    */
+    void ControlFlowGraph::find_blocks(Function *fptr) {
+      int64_t n = fptr->instructions.size();
+      std::unordered_map<std::string, int64_t> label_block;
+      block_of.assign(n, 0);
+      bool ends_block = true;
+      for (int64_t i = 0; i < n; i++) {
+        Instruction *iptr = fptr->instructions[i];
+        if (ends_block || iptr->kind == InstructionKind::label) {
+          block_first.push_back(i);
+          block_last.push_back(i);
+        }
+        block_last.back() = i;
+        block_of[i] = block_first.size() - 1;
+        if (iptr->kind == InstructionKind::label) {
+          label_block[static_cast<label_Instruction*>(iptr)->getLabel()] = block_of[i];
+        }
+        ends_block = jump_target(iptr) || !falls_through(iptr);
+      }
+
+      int64_t blocks = block_count();
+      successors.assign(blocks, {});
+      predecessors.assign(blocks, {});
+      auto link = [&](int64_t from, int64_t to) {
+        for (auto s : successors[from]) {
+          if (s == to) return;
+        }
+        successors[from].push_back(to);
+        predecessors[to].push_back(from);
+      };
+      for (int64_t b = 0; b < blocks; b++) {
+        Instruction *last = fptr->instructions[block_last[b]];
+        if (Label *target = as_label(jump_target(last))) {
+          auto it = label_block.find(target->value);
+          if (it != label_block.end()) link(b, it->second);
+        }
+        if (falls_through(last) && b + 1 < blocks) link(b, b + 1);
+      }
+    }
+
+    /*
+    Reverse postorder of an iterative DFS from the entry.
+    */
+    void ControlFlowGraph::order_blocks() {
+      int64_t blocks = block_count();
+      rpo_index.assign(blocks, -1);
+      if (blocks == 0) return;
+      std::vector<bool> visited(blocks, false);
+      std::vector<std::pair<int64_t, size_t>> dfs_stack;
+      dfs_stack.push_back({0, 0});
+      visited[0] = true;
+      while (!dfs_stack.empty()) {
+        auto& top = dfs_stack.back();
+        if (top.second < successors[top.first].size()) {
+          int64_t next = successors[top.first][top.second++];
+          if (!visited[next]) {
+            visited[next] = true;
+            dfs_stack.push_back({next, 0});
+          }
+        } else {
+          rpo.push_back(top.first);
+          dfs_stack.pop_back();
+        }
+      }
+      std::reverse(rpo.begin(), rpo.end());
+      for (int64_t k = 0; k < (int64_t)rpo.size(); k++) {
+        rpo_index[rpo[k]] = k;
+      }
+    }
+
+    /*
+    Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm": iterate idom over the blocks in reverse
+    postorder, intersecting the processed predecessors by walking up the tree until the two fingers meet.
+    */
+    void ControlFlowGraph::find_dominators() {
+      int64_t blocks = block_count();
+      idom.assign(blocks, -1);
+      if (blocks == 0) return;
+      idom[0] = 0;
+      auto intersect = [&](int64_t a, int64_t b) {
+        while (a != b) {
+          while (rpo_index[a] > rpo_index[b]) a = idom[a];
+          while (rpo_index[b] > rpo_index[a]) b = idom[b];
+        }
+        return a;
+      };
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (size_t k = 1; k < rpo.size(); k++) {
+          int64_t b = rpo[k];
+          int64_t new_idom = -1;
+          for (auto p : predecessors[b]) {
+            if (idom[p] == -1) continue;
+            new_idom = (new_idom == -1) ? p : intersect(p, new_idom);
+          }
+          if (new_idom != idom[b]) {
+            idom[b] = new_idom;
+            changed = true;
+          }
+        }
+      }
+
+      /*
+      Number the dominator tree in preorder: a dominates b exactly when b's interval lies inside a's.
+      */
+      std::vector<std::vector<int64_t>> children(blocks);
+      for (size_t k = 1; k < rpo.size(); k++) {
+        children[idom[rpo[k]]].push_back(rpo[k]);
+      }
+      dominator_enter.assign(blocks, -1);
+      dominator_exit.assign(blocks, -1);
+      int64_t clock = 0;
+      std::vector<std::pair<int64_t, size_t>> dfs_stack;
+      dfs_stack.push_back({0, 0});
+      dominator_enter[0] = clock++;
+      while (!dfs_stack.empty()) {
+        auto& top = dfs_stack.back();
+        if (top.second < children[top.first].size()) {
+          int64_t child = children[top.first][top.second++];
+          dominator_enter[child] = clock++;
+          dfs_stack.push_back({child, 0});
+        } else {
+          dominator_exit[top.first] = clock;
+          dfs_stack.pop_back();
+        }
+      }
+    }
+
+    bool ControlFlowGraph::dominates(int64_t a, int64_t b) const {
+      if (dominator_enter[a] == -1 || dominator_enter[b] == -1) return false;
+      return dominator_enter[a] <= dominator_enter[b] && dominator_exit[b] <= dominator_exit[a];
+    }
+
+    /*
+    Natural loops, one per header, each found by walking predecessors back from its latches until the header.
+    - headers are taken in reverse postorder, so an enclosing loop (whose header dominates this one's) is always
+      done first; each loop then overwrites loop_of for its blocks, and what it overwrites at its own header is
+      its parent.
+    */
+    void ControlFlowGraph::find_loops() {
+      int64_t blocks = block_count();
+      loop_of.assign(blocks, -1);
+      std::vector<int64_t> mark(blocks, -1);
+      std::vector<int64_t> worklist;
+      for (auto header : rpo) {
+        worklist.clear();
+        for (auto p : predecessors[header]) {
+          if (dominates(header, p)) worklist.push_back(p);
+        }
+        if (worklist.empty()) continue;
+
+        Loop loop;
+        loop.header = header;
+        loop.parent = loop_of[header];
+        loop.depth = (loop.parent == -1) ? 1 : loops[loop.parent].depth + 1;
+        int64_t id = loops.size();
+        mark[header] = id;
+        loop.blocks.push_back(header);
+        while (!worklist.empty()) {
+          int64_t b = worklist.back();
+          worklist.pop_back();
+          if (mark[b] == id) continue;
+          mark[b] = id;
+          loop.blocks.push_back(b);
+          for (auto p : predecessors[b]) {
+            if (mark[p] != id && rpo_index[p] != -1) worklist.push_back(p);
+          }
+        }
+        for (auto b : loop.blocks) loop_of[b] = id;
+        loops.push_back(std::move(loop));
+      }
+    }
+
+    int64_t ControlFlowGraph::loop_depth(int64_t block) const {
+      return (loop_of[block] == -1) ? 0 : loops[loop_of[block]].depth;
+    }
+
+}
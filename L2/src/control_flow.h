@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace L2 {
+
+    class Function;
+
+    /*
+    Basic block CFG of a function, with its dominator tree and loop nesting forest.
+    - a block starts at the first instruction, at every label and after every jump, return or call that doesn't
+      come back; block 0 is the entry. Blocks are numbered in instruction order.
+    - rpo lists the blocks reachable from the entry in reverse postorder; unreachable blocks have rpo_index -1,
+      no immediate dominator and no loop.
+    - loops are the natural loops of the back edges (an edge to a block that dominates its source), one per
+      header, ordered outermost first: a loop's parent always comes before it. A cycle entered at more than
+      one block (irreducible) has no back edge and so no loop.
+    - built with Function::control_flow, which caches it until the function's instructions are rewritten.
+    */
+    class ControlFlowGraph {
+        public:
+            struct Loop {
+                int64_t header;
+                int64_t parent;                 // enclosing loop, -1 for an outermost one
+                int64_t depth;                  // 1 for an outermost loop
+                std::vector<int64_t> blocks;    // every block in the loop, inner loops included
+            };
+
+            void build(Function *fptr);
+            void clear();
+            bool valid = false;
+
+            std::vector<int64_t> block_first;   // first instruction of each block
+            std::vector<int64_t> block_last;    // last instruction of each block
+            std::vector<int64_t> block_of;      // block of each instruction
+            std::vector<std::vector<int64_t>> successors;
+            std::vector<std::vector<int64_t>> predecessors;
+
+            std::vector<int64_t> rpo;
+            std::vector<int64_t> rpo_index;
+            std::vector<int64_t> idom;          // immediate dominator, the entry is its own
+
+            std::vector<Loop> loops;
+            std::vector<int64_t> loop_of;       // innermost loop containing each block, -1 for none
+
+            int64_t block_count() const { return block_first.size(); }
+            bool dominates(int64_t a, int64_t b) const;
+            int64_t loop_depth(int64_t block) const;
+
+        private:
+            void find_blocks(Function *fptr);
+            void order_blocks();
+            void find_dominators();
+            void find_loops();
+
+            std::vector<int64_t> dominator_enter;   // preorder interval of each block in the dominator tree,
+            std::vector<int64_t> dominator_exit;    // so dominates() is two comparisons
+    };
+
+}
@@ -0,0 +1,665 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "execution.h"
+
+namespace L2 {
+
+    namespace {
+
+        const int64_t stack_words = 1 << 24;    // 128MB of address space, only the part the program touches is used
+        const int64_t rsp_number = 7;
+        const int64_t heap_words = 1 << 20;     // the heap size of runtime.c, a new one is added when it is full
+
+        const std::unordered_map<std::string, int64_t> register_numbers = {
+          {"rax", 0}, {"rbx", 1}, {"rcx", 2}, {"rdx", 3}, {"rsi", 4}, {"rdi", 5}, {"rbp", 6}, {"rsp", 7},
+          {"r8", 8}, {"r9", 9}, {"r10", 10}, {"r11", 11}, {"r12", 12}, {"r13", 13}, {"r14", 14}, {"r15", 15}
+        };
+
+        /*
+        Arithmetic wraps around as it does on the machine.
+        */
+        inline int64_t wrap_add(int64_t a, int64_t b) { return (int64_t)((uint64_t)a + (uint64_t)b); }
+        inline int64_t wrap_sub(int64_t a, int64_t b) { return (int64_t)((uint64_t)a - (uint64_t)b); }
+        inline int64_t wrap_mul(int64_t a, int64_t b) { return (int64_t)((uint64_t)a * (uint64_t)b); }
+
+    }
+
+    /*
+    Turns the instructions of one function into Steps.
+    */
+    class DecodeVisitor : public Visitor {
+      public:
+        DecodeVisitor(Interpreter *interpreter) : interpreter(interpreter) {}
+        Interpreter::Operand operand(Item *item) { return interpreter->decode(item, slots); }
+        int64_t number(Item *item) { return as_number(item) ? as_number(item)->value : 0; }
+        int64_t position(Item *label) {
+          auto found = interpreter->labels.find(label->print());
+          return (found == interpreter->labels.end()) ? -1 : found->second->position;
+        }
+        void visit(Instruction_ret *instruction) override {}
+        void visit(Instruction_assignment *instruction) override {
+          step.a = operand(instruction->d);
+          step.b = operand(instruction->s);
+        }
+        void visit(label_Instruction *instruction) override {}
+        void visit(goto_label_instruction *instruction) override {
+          step.n = position(instruction->label);
+        }
+        void visit(Call_tenserr_Instruction *instruction) override {
+          step.n = number(instruction->F);
+        }
+        void visit(Call_uN_Instruction *instruction) override {
+          step.a = operand(instruction->u);
+          step.n = number(instruction->N);
+        }
+        void visit(Call_print_Instruction *instruction) override {}
+        void visit(Call_input_Instruction *instruction) override {}
+        void visit(Call_allocate_Instruction *instruction) override {}
+        void visit(Call_tuple_Instruction *instruction) override {}
+        void visit(w_increment_decrement *instruction) override {
+          step.a = operand(instruction->r);
+          step.op = interpreter->decode(instruction->symbol);
+        }
+        void visit(w_atreg_assignment *instruction) override {
+          step.a = operand(instruction->r1);
+          step.b = operand(instruction->r2);
+          step.c = operand(instruction->r3);
+          step.n = number(instruction->E);
+        }
+        void visit(Memory_assignment_store *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->s);
+          step.n = number(instruction->M);
+        }
+        void visit(Memory_assignment_load *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->x);
+          step.n = number(instruction->M);
+        }
+        void visit(Memory_arithmetic_load *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->x);
+          step.op = interpreter->decode(instruction->instruction);
+          step.n = number(instruction->M);
+        }
+        void visit(Memory_arithmetic_store *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->t);
+          step.op = interpreter->decode(instruction->instruction);
+          step.n = number(instruction->M);
+        }
+        void visit(cmp_Instruction *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->t2);
+          step.c = operand(instruction->t1);
+          step.op = interpreter->decode(instruction->method);
+        }
+        void visit(cjump_cmp_Instruction *instruction) override {
+          step.a = operand(instruction->t2);
+          step.b = operand(instruction->t1);
+          step.op = interpreter->decode(instruction->cmp);
+          step.n = position(instruction->label);
+        }
+        void visit(stackarg_assignment *instruction) override {
+          step.a = operand(instruction->w);
+          step.n = number(instruction->M);
+        }
+        void visit(AOP_assignment *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->src);
+          step.op = interpreter->decode(instruction->method);
+        }
+        void visit(SOP_assignment *instruction) override {
+          step.a = operand(instruction->dst);
+          step.b = operand(instruction->src);
+          step.op = interpreter->decode(instruction->method);
+        }
+
+        Interpreter *interpreter;
+        std::unordered_map<std::string, int64_t> slots;
+        Interpreter::Step step;
+    };
+
+    Interpreter::Interpreter(Program &p, bool allocated) : function_list(p.functions), decoded(p.functions.size()) {
+
+      /*
+      Labels first, jumps and label values can point forward (or into other functions, for return addresses).
+      */
+      for (size_t f = 0; f < function_list.size(); f++) {
+        if (function_list[f]->name == p.entryPointLabel) entry = f;
+        for (size_t i = 0; i < function_list[f]->instructions.size(); i++) {
+          Instruction *iptr = function_list[f]->instructions[i];
+          if (iptr->kind != InstructionKind::label) continue;
+          label_tokens.push_back({(int64_t)f, (int64_t)i});
+          labels[static_cast<label_Instruction*>(iptr)->getLabel()] = &label_tokens.back();
+          label_values.insert((int64_t)&label_tokens.back());
+        }
+      }
+
+      for (size_t f = 0; f < function_list.size(); f++) {
+        DecodedFunction &function = decoded[f];
+        function.function = function_list[f];
+        function.frame_words = allocated ? function_list[f]->locals : 0;
+        DecodeVisitor decoder(this);
+        for (Instruction *iptr : function_list[f]->instructions) {
+          decoder.step = Step();
+          decoder.step.kind = iptr->kind;
+          iptr->accept(&decoder);
+          function.steps.push_back(decoder.step);
+        }
+        function.variables = decoder.slots.size();
+      }
+    }
+
+    Interpreter::Operand Interpreter::decode(Item *item, std::unordered_map<std::string, int64_t> &slots) {
+      Operand operand;
+      switch (item->kind) {
+        case ItemKind::number:
+          operand.kind = OperandKind::imm;
+          operand.index = static_cast<Number*>(item)->value;
+          break;
+        case ItemKind::label: {
+          auto found = labels.find(item->print());
+          operand.kind = OperandKind::imm;
+          operand.index = (found == labels.end()) ? 0 : (int64_t)found->second;
+          break;
+        }
+        case ItemKind::name: {
+          operand.kind = OperandKind::imm;
+          for (size_t f = 0; f < function_list.size(); f++) {
+            if (function_list[f]->name == item->print()) operand.index = (int64_t)&decoded[f];
+          }
+          break;
+        }
+        case ItemKind::variable:
+        case ItemKind::reg: {
+
+          /*
+          Allocation colors a variable by renaming it, so registers are told apart by name rather than by kind.
+          */
+          const std::string &name = static_cast<Variable*>(item)->name;
+          auto reg = register_numbers.find(name);
+          if (reg != register_numbers.end()) {
+            operand.kind = OperandKind::reg;
+            operand.index = reg->second;
+          } else {
+            operand.kind = OperandKind::var;
+            operand.index = slots.emplace(name, (int64_t)slots.size()).first->second;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+      return operand;
+    }
+
+    Interpreter::Op Interpreter::decode(Item *op) {
+      const std::string sign = op->print();
+      if (sign == "+=") return Op::add;
+      if (sign == "-=") return Op::sub;
+      if (sign == "*=") return Op::mul;
+      if (sign == "&=") return Op::band;
+      if (sign == "<<=") return Op::shl;
+      if (sign == ">>=") return Op::shr;
+      if (sign == "<") return Op::less;
+      if (sign == "<=") return Op::less_equal;
+      if (sign == "=") return Op::equal;
+      if (sign == "++") return Op::increment;
+      if (sign == "--") return Op::decrement;
+      std::cerr << "Unknown operator " << sign << std::endl;
+      return Op::none;
+    }
+
+    int64_t Interpreter::read(const Operand &operand, const Frame &frame) const {
+      switch (operand.kind) {
+        case OperandKind::reg:
+          return registers[operand.index];
+        case OperandKind::var:
+          return frame.variables[operand.index];
+        default:
+          return operand.index;
+      }
+    }
+
+    void Interpreter::write(const Operand &operand, Frame &frame, int64_t value) {
+      if (operand.kind == OperandKind::reg) registers[operand.index] = value;
+      else if (operand.kind == OperandKind::var) frame.variables[operand.index] = value;
+    }
+
+    int64_t Interpreter::function_of(int64_t value) const {
+      int64_t offset = value - (int64_t)decoded.data();
+      if (offset < 0 || offset % (int64_t)sizeof(DecodedFunction) != 0) return -1;
+      int64_t f = offset / (int64_t)sizeof(DecodedFunction);
+      return (f < (int64_t)decoded.size()) ? f : -1;
+    }
+
+    /*
+    Jumping to a function: "call" already made room for the return address and the stack arguments, the function
+    makes room for its locals.
+    */
+    bool Interpreter::enter(int64_t function, std::vector<Frame> &frames) {
+      frames.push_back({function, 0, std::vector<int64_t>(decoded[function].variables, 0)});
+      registers[rsp_number] -= 8 * decoded[function].frame_words;
+      return (uint64_t)registers[rsp_number] - (uint64_t)stack.get() < (uint64_t)(8 * stack_words);
+    }
+
+    /*
+    The host pointer of the 8 bytes at address, when all of them are in the stack or in one heap chunk. Addresses
+    are compared as unsigned numbers, so a wrapped around one is rejected rather than overflowing.
+    */
+    int64_t* Interpreter::memory(int64_t address) const {
+      auto inside = [address](const int64_t *words, int64_t size) {
+        uint64_t offset = (uint64_t)address - (uint64_t)words;
+        return offset <= (uint64_t)(8 * size - 8);
+      };
+      if (inside(stack.get(), stack_words)) return (int64_t*)address;
+      for (const HeapChunk &chunk : heap) {
+        if (inside(chunk.words.get(), chunk.size)) return (int64_t*)address;
+      }
+      return nullptr;
+    }
+
+    int Interpreter::run() {
+      if (entry < 0) {
+        std::cerr << "The entry point is not a function of the program" << std::endl;
+        return 1;
+      }
+      stack.reset(new int64_t[stack_words]);
+
+      /*
+      The state runtime.c hands to the program: "go" calls the entry point with these registers set.
+      */
+      registers[1] = 1;
+      registers[5] = 3;
+      registers[4] = 5;
+      registers[rsp_number] = (int64_t)(stack.get() + stack_words);
+      registers[rsp_number] -= 8;
+      *(int64_t*)registers[rsp_number] = (int64_t)&exit_token;
+
+      std::vector<Frame> frames;
+      if (!enter(entry, frames)) {
+        std::cerr << "Stack overflow entering " << function_list[entry]->name << std::endl;
+        return 1;
+      }
+      while (true) {
+        Frame &frame = frames.back();
+        DecodedFunction &function = decoded[frame.function];
+        if (frame.pc >= (int64_t)function.steps.size()) {
+          std::cerr << "Execution fell off the end of " << function.function->name << std::endl;
+          return 1;
+        }
+        const Step &step = function.steps[frame.pc++];
+        ExecutionCounters &counters = function.counters;
+        if (step.kind != InstructionKind::label) counters.instructions++;
+
+        switch (step.kind) {
+          case InstructionKind::label:
+            break;
+
+          case InstructionKind::assignment:
+            if (step.b.kind == OperandKind::reg || step.b.kind == OperandKind::var) counters.moves++;
+            write(step.a, frame, read(step.b, frame));
+            break;
+
+          case InstructionKind::goto_label:
+            if (step.n < 0) {
+              std::cerr << "Jump to an unknown label in " << function.function->name << std::endl;
+              return 1;
+            }
+            frame.pc = step.n;
+            break;
+
+          case InstructionKind::cjump: {
+            int64_t left = read(step.a, frame);
+            int64_t right = read(step.b, frame);
+            bool taken = (step.op == Op::less) ? left < right : (step.op == Op::less_equal) ? left <= right : left == right;
+            if (taken) {
+              if (step.n < 0) {
+                std::cerr << "Jump to an unknown label in " << function.function->name << std::endl;
+                return 1;
+              }
+              frame.pc = step.n;
+            }
+            break;
+          }
+
+          case InstructionKind::cmp: {
+            int64_t left = read(step.b, frame);
+            int64_t right = read(step.c, frame);
+            bool result = (step.op == Op::less) ? left < right : (step.op == Op::less_equal) ? left <= right : left == right;
+            write(step.a, frame, result ? 1 : 0);
+            break;
+          }
+
+          case InstructionKind::aop:
+          case InstructionKind::sop: {
+            int64_t value = read(step.a, frame);
+            int64_t source = read(step.b, frame);
+            switch (step.op) {
+              case Op::add: value = wrap_add(value, source); break;
+              case Op::sub: value = wrap_sub(value, source); break;
+              case Op::mul: value = wrap_mul(value, source); break;
+              case Op::band: value &= source; break;
+              case Op::shl: value = (int64_t)((uint64_t)value << (source & 63)); break;
+              case Op::shr: value >>= (source & 63); break;
+              default: break;
+            }
+            write(step.a, frame, value);
+            break;
+          }
+
+          case InstructionKind::increment_decrement:
+            write(step.a, frame, wrap_add(read(step.a, frame), (step.op == Op::increment) ? 1 : -1));
+            break;
+
+          case InstructionKind::atreg:
+            write(step.a, frame, wrap_add(read(step.b, frame), wrap_mul(read(step.c, frame), step.n)));
+            break;
+
+          case InstructionKind::memory_load: {
+            counters.loads++;
+            if (step.b.kind == OperandKind::reg && step.b.index == rsp_number) counters.stack_loads++;
+            int64_t *address = memory(wrap_add(read(step.b, frame), step.n));
+            if (address == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            write(step.a, frame, *address);
+            break;
+          }
+
+          case InstructionKind::memory_store: {
+            counters.stores++;
+            if (step.a.kind == OperandKind::reg && step.a.index == rsp_number) counters.stack_stores++;
+            int64_t *address = memory(wrap_add(read(step.a, frame), step.n));
+            if (address == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            *address = read(step.b, frame);
+            break;
+          }
+
+          case InstructionKind::memory_arithmetic_load: {
+            counters.loads++;
+            if (step.b.kind == OperandKind::reg && step.b.index == rsp_number) counters.stack_loads++;
+            int64_t *address = memory(wrap_add(read(step.b, frame), step.n));
+            if (address == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            int64_t value = read(step.a, frame);
+            write(step.a, frame, (step.op == Op::add) ? wrap_add(value, *address) : wrap_sub(value, *address));
+            break;
+          }
+
+          case InstructionKind::memory_arithmetic_store: {
+            counters.loads++;
+            counters.stores++;
+            if (step.a.kind == OperandKind::reg && step.a.index == rsp_number) {
+              counters.stack_loads++;
+              counters.stack_stores++;
+            }
+            int64_t *address = memory(wrap_add(read(step.a, frame), step.n));
+            if (address == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            int64_t value = read(step.b, frame);
+            *address = (step.op == Op::add) ? wrap_add(*address, value) : wrap_sub(*address, value);
+            break;
+          }
+
+          case InstructionKind::stackarg: {
+            counters.loads++;
+            counters.stack_loads++;
+            int64_t *address = memory(wrap_add(registers[rsp_number], step.n + 8 * function.frame_words));
+            if (address == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            write(step.a, frame, *address);
+            break;
+          }
+
+          case InstructionKind::call_uN: {
+            counters.calls++;
+            int64_t callee = function_of(read(step.a, frame));
+            if (callee < 0) {
+              std::cerr << "Call to something that is not a function in " << function.function->name << std::endl;
+              return 1;
+            }
+            registers[rsp_number] -= 8 * (1 + ((step.n > 6) ? step.n - 6 : 0));
+            if (!enter(callee, frames)) {
+              std::cerr << "Stack overflow calling " << function_list[callee]->name << " in " << function.function->name << std::endl;
+              return 1;
+            }
+            break;
+          }
+
+          case InstructionKind::ret: {
+            int64_t arguments = function.function->arguments;
+            registers[rsp_number] += 8 * (function.frame_words + ((arguments > 6) ? arguments - 6 : 0));
+            int64_t *top = memory(registers[rsp_number]);
+            if (top == nullptr) {
+              std::cerr << "Memory access out of range in " << function.function->name << std::endl;
+              return 1;
+            }
+            int64_t return_address = *top;
+            registers[rsp_number] += 8;
+            frames.pop_back();
+            if (return_address == (int64_t)&exit_token) {
+              std::cout.flush();
+              return 0;
+            }
+            if (frames.empty() || !label_values.count(return_address)
+                || ((LabelToken*)return_address)->function != frames.back().function) {
+              std::cerr << "Return to something that is not a label of the caller from " << function.function->name << std::endl;
+              return 1;
+            }
+            frames.back().pc = ((LabelToken*)return_address)->position;
+            break;
+          }
+
+          case InstructionKind::call_print:
+            counters.calls++;
+            if (!runtime_print(registers[5])) return status;
+            registers[0] = 1;
+            break;
+
+          case InstructionKind::call_input:
+            counters.calls++;
+            registers[0] = runtime_input();
+            break;
+
+          case InstructionKind::call_allocate:
+            counters.calls++;
+            if (!runtime_allocate(registers[5], registers[4], registers[0])) return status;
+            break;
+
+          case InstructionKind::call_tuple:
+            counters.calls++;
+            index_error(registers[5], registers[4], registers[3], "tuple-error (line, length, index)", "a tuple");
+            return status;
+
+          case InstructionKind::call_tenserr:
+            counters.calls++;
+            if (step.n == 1) null_error(registers[5]);
+            else if (step.n == 3) index_error(registers[5], registers[4], registers[3], "tensor-error (line, length, index)", "an array");
+            else tensor_error(registers[5], registers[4], registers[3], registers[2]);
+            return status;
+        }
+      }
+    }
+
+    /*
+    The runtime functions, printing what runtime.c prints.
+    */
+    bool Interpreter::runtime_print(int64_t value) {
+      print_content(value, 0);
+      if (status != 0) return false;
+      std::cout << "\n";
+      return true;
+    }
+
+    void Interpreter::print_content(int64_t value, int depth) {
+      if (depth >= 4) {
+        std::cout << "...";
+        return;
+      }
+      if (value == 0) {
+        std::cout << "nil";
+        return;
+      }
+      if (value & 1) {
+        std::cout << (value >> 1);
+        return;
+      }
+      int64_t *array = memory(value);
+      if (array == nullptr || (array[0] > 0 && memory(wrap_add(value, wrap_mul(8, array[0]))) == nullptr)) {
+        std::cerr << "print called with an address out of range" << std::endl;
+        status = 1;
+        return;
+      }
+      int64_t size = array[0];
+      std::cout << "{s:" << size;
+      for (int64_t i = 0; i < size; i++) {
+        std::cout << ", ";
+        print_content(array[i + 1], depth + 1);
+        if (status != 0) return;
+      }
+      std::cout << "}";
+      if (size == -1) {
+        std::cout << "\nfound -1 in an array; internal GC failure\n";
+        status = 255;
+      }
+    }
+
+    int64_t Interpreter::runtime_input() {
+      std::string number;
+      int c;
+      while ((c = std::cin.get()) != EOF && c != '\n' && c != '\r') number.push_back((char)c);
+      int64_t n = std::atoll(number.c_str());
+      return (int64_t)((uint64_t)n << 1) | 1;
+    }
+
+    bool Interpreter::runtime_allocate(int64_t size, int64_t fill, int64_t &result) {
+      if (!(size & 1)) {
+        std::cout << "allocate called with size input that was not an encoded integer, " << size << "\n";
+        status = 255;
+        return false;
+      }
+      int64_t data_size = size >> 1;
+      if (data_size < 0) {
+        std::cout << "allocate called with size of " << (int)data_size << "\n";
+        status = 255;
+        return false;
+      }
+      int64_t array_size = (data_size == 0) ? 2 : data_size + 1;
+      if (heap_next + array_size > heap_end) {
+        int64_t words = std::max(heap_words, array_size);
+        heap.push_back({std::unique_ptr<int64_t[]>(new int64_t[words]()), words});
+        heap_next = heap.back().words.get();
+        heap_end = heap_next + words;
+      }
+      int64_t *array = heap_next;
+      heap_next += array_size;
+      array[0] = data_size;
+      if (data_size == 0) array[1] = 1;
+      for (int64_t i = 1; i <= data_size; i++) array[i] = fill;
+      result = (int64_t)array;
+      return true;
+    }
+
+    /*
+    The error calls end the program with status 0 once they have printed their message; a call with arguments that
+    are not encoded (or an index that is in range) is a bug of the program and aborts it.
+    */
+    bool Interpreter::encoded(int64_t value, const char *position, const char *call) {
+      if ((value & 1) == 1) return true;
+      std::cout << "ERROR: the " << position << " input of a call to \"" << call << "\" is not encoded\n";
+      std::cout.flush();
+      std::abort();
+    }
+
+    void Interpreter::null_error(int64_t line) {
+      encoded(line, "first", "tensor-error (line)");
+      std::cout << "ERROR: instruction at line " << (line >> 1)
+                << " attempted to access an array, a tuple, or a tensor that has not been allocated\n";
+      status = 0;
+    }
+
+    void Interpreter::index_error(int64_t line, int64_t length, int64_t index, const char *call, const char *container) {
+      encoded(line, "first", call);
+      encoded(length, "second", call);
+      encoded(index, "third", call);
+      line >>= 1;
+      length >>= 1;
+      index >>= 1;
+      if (index < 0) {
+        std::cout << "ERROR: instruction at line " << line << " attempted to use the negative index " << index << "\n";
+        status = 0;
+        return;
+      }
+      if (index < length) {
+        std::string name(call);
+        name.erase(name.find(' '), 1);
+        std::cout << "ERROR: the call triggered by line " << (int)line << " to \"" << name << "\" is incorrect, the index "
+                  << (int)index << " is within the accepted range (the length is " << (int)length << ")\n";
+        std::cout.flush();
+        std::abort();
+      }
+      std::cout << "ERROR: instruction at line " << line << " attempted to use position " << index << " in " << container
+                << " that only has " << length << " element" << ((length != 1) ? "s" : "") << "\n";
+      status = 0;
+    }
+
+    void Interpreter::tensor_error(int64_t line, int64_t dimension, int64_t length, int64_t index) {
+      const char *call = "tensor-error (line, dimension, length, index)";
+      encoded(line, "first", call);
+      encoded(dimension, "second", call);
+      encoded(length, "third", call);
+      encoded(index, "forth", call);
+      line >>= 1;
+      dimension >>= 1;
+      length >>= 1;
+      index >>= 1;
+      if (index < 0) {
+        std::cout << "ERROR: instruction at line " << line << " attempted to use the negative index " << index
+                  << " in the dimension " << dimension << "\n";
+        status = 0;
+        return;
+      }
+      if (index < length) {
+        std::cout << "ERROR: a call to \"" << call << "\" is incorrect, index is within the accepted range\n";
+        std::cout.flush();
+        std::abort();
+      }
+      std::cout << "ERROR: instruction at line " << line << " attempted to use position " << index << " in the dimension "
+                << dimension << " of a tensor that only has " << length << " element" << ((length != 1) ? "s" : "")
+                << " in that dimension\n";
+      status = 0;
+    }
+
+    void print_execution_report(std::ostream &out, const Interpreter &interpreter) {
+      const std::vector<Function*> &functions = interpreter.functions();
+      out << "{\"functions\": [" << std::endl;
+      for (size_t i = 0; i < functions.size(); i++) {
+        const ExecutionCounters &counters = interpreter.counters(i);
+        out << "{\"name\": \"" << functions[i]->name << "\""
+            << ", \"instructions\": " << counters.instructions
+            << ", \"loads\": " << counters.loads
+            << ", \"stores\": " << counters.stores
+            << ", \"stack_loads\": " << counters.stack_loads
+            << ", \"stack_stores\": " << counters.stack_stores
+            << ", \"moves\": " << counters.moves
+            << ", \"calls\": " << counters.calls << "}"
+            << (i + 1 < functions.size() ? "," : "") << std::endl;
+      }
+      out << "]}" << std::endl;
+    }
+
+}
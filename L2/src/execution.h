@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "L2.h"
+
+namespace L2 {
+
+    /*
+    What one function did while the program ran, for the interpreter's -c report.
+    - loads and stores count every memory access (stack-arg included), the stack ones are the part of them that goes
+      through rsp: return addresses, stack arguments and, once registers are allocated, spill code.
+    - a "mem x M += t" is one load and one store.
+    */
+    struct ExecutionCounters {
+        int64_t instructions = 0;       // labels are not counted
+        int64_t loads = 0;
+        int64_t stores = 0;
+        int64_t stack_loads = 0;
+        int64_t stack_stores = 0;
+        int64_t moves = 0;              // variable or register to variable or register
+        int64_t calls = 0;              // runtime calls included
+    };
+
+    /*
+    Runs an L2 program the way the compiled binary would, on a simulated machine.
+    - registers are global and rsp points into a real stack, so return addresses, stack arguments and spill slots
+      behave as in the generated code; variables live in the frame of the call that uses them. This makes it run
+      both a parsed program and one whose registers have already been allocated.
+    - heap values are host pointers to arrays laid out as the runtime lays them out (length, then the elements),
+      labels and function names are addresses of private tokens. There is no garbage collector, a full heap is
+      followed by a new one.
+    - every load, store and move of rsp is checked against the stack and the heap chunks; one that leaves them
+      stops the program with a message, where the binary would crash or silently corrupt memory.
+    - print, input, allocate and the error calls follow lib/runtime.c, output included.
+    */
+    class Interpreter {
+      public:
+        Interpreter(Program &p, bool allocated);
+        int run();      // the exit status the binary would have
+        const std::vector<Function*>& functions() const { return function_list; }
+        const ExecutionCounters& counters(int64_t function) const { return decoded[function].counters; }
+
+      private:
+        enum class OperandKind : uint8_t {
+          none,
+          reg,
+          var,
+          imm
+        };
+        struct Operand {
+          OperandKind kind = OperandKind::none;
+          int64_t index = 0;            // register number, variable slot or the immediate value
+        };
+        enum class Op : uint8_t {
+          none,
+          add,
+          sub,
+          mul,
+          band,
+          shl,
+          shr,
+          less,
+          less_equal,
+          equal,
+          increment,
+          decrement
+        };
+        /*
+        One decoded instruction; a, b and c follow the order of the operands in the L2 syntax.
+        */
+        struct Step {
+          InstructionKind kind;
+          Op op = Op::none;
+          Operand a;
+          Operand b;
+          Operand c;
+          int64_t n = 0;                // M, E, N, F or the position a jump goes to
+        };
+        struct DecodedFunction {
+          Function *function;
+          std::vector<Step> steps;
+          int64_t variables = 0;
+          int64_t frame_words = 0;      // locals, once they are allocated
+          ExecutionCounters counters;
+        };
+        struct LabelToken {
+          int64_t function;
+          int64_t position;
+        };
+        struct Frame {
+          int64_t function;
+          int64_t pc;
+          std::vector<int64_t> variables;
+        };
+
+        struct HeapChunk {
+          std::unique_ptr<int64_t[]> words;
+          int64_t size;
+        };
+
+        friend class DecodeVisitor;
+        Operand decode(Item *item, std::unordered_map<std::string, int64_t> &slots);
+        Op decode(Item *op);
+        bool enter(int64_t function, std::vector<Frame> &frames);     // false when the stack is full
+        int64_t* memory(int64_t address) const;                       // nullptr outside the stack and the heap
+        int64_t read(const Operand &operand, const Frame &frame) const;
+        void write(const Operand &operand, Frame &frame, int64_t value);
+        int64_t function_of(int64_t value) const;     // -1 when the value is not a function name
+
+        bool runtime_print(int64_t value);      // false when the program has to stop, with status
+        int64_t runtime_input();
+        bool runtime_allocate(int64_t size, int64_t fill, int64_t &result);
+        void print_content(int64_t value, int depth);
+        bool encoded(int64_t value, const char *position, const char *call);
+        void null_error(int64_t line);
+        void index_error(int64_t line, int64_t length, int64_t index, const char *call, const char *container);
+        void tensor_error(int64_t line, int64_t dimension, int64_t length, int64_t index);
+
+        std::vector<Function*> function_list;
+        std::vector<DecodedFunction> decoded;
+        int64_t entry = -1;
+        std::deque<LabelToken> label_tokens;
+        std::unordered_map<std::string, LabelToken*> labels;
+        std::unordered_set<int64_t> label_values;
+        LabelToken exit_token;                      // the return address of the entry point
+        int64_t registers[16] = {};
+        std::unique_ptr<int64_t[]> stack;
+        std::vector<HeapChunk> heap;                    // zeroed and bump allocated like the runtime's heap, so
+        int64_t *heap_next = nullptr;                   // programs that write past an array still see what the
+        int64_t *heap_end = nullptr;                    // binary would
+        int status = 0;
+    };
+
+    /*
+    The counters as JSON, one function per line like the allocation report, for L2/scripts/dynamicOverhead.sh.
+    */
+    void print_execution_report(std::ostream &out, const Interpreter &interpreter);
+
+}
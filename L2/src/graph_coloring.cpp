@@ -7,7 +7,7 @@ namespace L2 {
     // list of general purpose registors for convenience
     // manually sorted according to the slides
     // should probably put this in L2 later
-    std::vector<std::string> gp_registers{
+    const std::vector<std::string> gp_registers{
         "r10",
         "r11",
         "r8",
@@ -72,63 +72,114 @@ namespace L2 {
     }
 
     /*
-    -We'll track the general ordering of the nodes based on their degree in a priority queue data structure. This will be used in tandem
-    with an unordered map which maps Nodes to their positions in the std::priority_queue vector. This allows us to access neighbors
-    that aren't at the top of the queue meaning we can update their degrees and position in the queue (this might be tricky, in order
-    for a node's position to be updated, does it need to be popped and then reinserted into the queue?)
-    -It might make sense to keep two priority queues, one for nodes with degree < num registers and one for degree >= num registers.
-    -Alternatively, it could be nice to just repeatedly pop from the priority queue and into a regular queue until we see a node with
-    degree < num registers. If the priority queue empties before we find a node with a small enough degree, then we have already 
-    conveniently stored the large-degree nodes with the correct ordering. 
+    Degree bucketed worklists for the simplify phase.
+    */
+    DegreeWorklists::DegreeWorklists(Graph *graph, int64_t colors)
+        : graph(graph), colors(colors), count(0), max_degree(0) {
+      size_t node_count = graph->node_list.size();
+      bucket_head.assign(node_count + 1, -1);
+      next.assign(node_count, -1);
+      prev.assign(node_count, -1);
+      bucket_of.assign(node_count, -1);
+      for (auto node : graph->getVarNodes()) {
+        link(node->id, node->degree);
+        count++;
+      }
+    }
+
+    bool DegreeWorklists::empty() const {
+      return count == 0;
+    }
+
+    void DegreeWorklists::link(int64_t id, int64_t degree) {
+      bucket_of[id] = degree;
+      prev[id] = -1;
+      next[id] = bucket_head[degree];
+      if (next[id] != -1) prev[next[id]] = id;
+      bucket_head[degree] = id;
+      if (degree > max_degree) max_degree = degree;
+      if (degree >= colors) {
+        Node* node = graph->node_list[id];
+        spill_candidates.push(std::make_tuple(node->spill_cost / degree, -degree, id));
+      }
+    }
+
+    void DegreeWorklists::unlink(int64_t id) {
+      int64_t degree = bucket_of[id];
+      if (prev[id] != -1) next[prev[id]] = next[id];
+      else bucket_head[degree] = next[id];
+      if (next[id] != -1) prev[next[id]] = prev[id];
+      bucket_of[id] = -1;
+    }
+
+    Node* DegreeWorklists::pop_low_degree() {
+      /*
+      Mirror the old heuristic: among the nodes with degree < colors, take the one with the largest degree.
+      The scan is bounded by the number of colors, so it's constant time.
+      */
+      for (int64_t degree = std::min(colors - 1, max_degree); degree >= 0; degree--) {
+        if (bucket_head[degree] != -1) {
+          int64_t id = bucket_head[degree];
+          unlink(id);
+          count--;
+          return graph->node_list[id];
+        }
+      }
+      return nullptr;
+    }
+
+    Node* DegreeWorklists::pop_spill_candidate() {
+      /*
+      Only called when every node left has degree >= colors, so every one of them has a fresh heap entry.
+      Among equal ratios (e.g. only spill temporaries left, all infinite) the higher degree node goes first.
+      */
+      while (!spill_candidates.empty()) {
+        auto top = spill_candidates.top();
+        spill_candidates.pop();
+        int64_t id = std::get<2>(top);
+        if (bucket_of[id] != -std::get<1>(top)) continue;
+        unlink(id);
+        count--;
+        return graph->node_list[id];
+      }
+      return nullptr;
+    }
+
+    void DegreeWorklists::remove(Node *node) {
+      graph->removeNode(node);
+      for (auto neighbor_id : graph->adjacency[node->id]) {
+        if (bucket_of[neighbor_id] == -1) continue;
+        Node* neighbor = graph->node_list[neighbor_id];
+        unlink(neighbor_id);
+        link(neighbor_id, neighbor->degree);
+      }
+    }
+
+    /*
+    Step 1 of the coloring algorithm (simplify): repeatedly take a node with degree < number of colors out of the graph,
+    and when there is none take the node with the lowest spill cost / degree as a potential spill. Nodes come out of the degree worklists above,
+    so each removal costs O(degree) instead of re-sorting every node in the graph.
     */
     std::vector<Node*> depopulate(Graph *graph) {
       /*
       Initialize our return stack to hold the variable ordering.
       */
       std::vector<Node*> stack;
+      DegreeWorklists worklists(graph, gp_registers.size());
 
       /*
       Iterate until we've removed all non-register nodes.
       */
-      while (graph->getSize() > 0) {
-
-        /*
-        Get and sort a list of the current variable nodes in the graph in non-decreasing order 
-        */
-        std::vector<Node*> curr_nodes = graph->getVarNodes();
-        if (curr_nodes.empty()) {
-            // No more variable nodes to process, break out of the loop
-            // or handle this scenario according to your algorithm's logic
-            if (debug) std::cerr << "No more variable nodes to process.\n";
-            break; // or return stack; depending on your algorithm's requirements
-        }
-        std::sort(curr_nodes.begin(), curr_nodes.end(), cmp);
-        
-        /*
-        Initialize a best-so-far variable and check for the largest degree node less than N.
-        */
-        Node* best_node = nullptr;
-        /*
-        Iterate left to right (ie in the order of increasing degree)
-        */
-        for (auto node : curr_nodes) {
-            if (node->degree >= gp_registers.size()) {
-                /*
-                If we encounter a node with degree greater than or equal to the number of colors,
-                then stop searching the list of nodes since we know the far right will be the best.
-                */
-                break;
-            }
-            best_node = node;
-        }
+      while (!worklists.empty()) {
+        Node* best_node = worklists.pop_low_degree();
         if (best_node == nullptr) {
           /*
-          Then there weren't any small degree nodes. Far right now holds the best.
+          Then there weren't any small degree nodes, take the highest degree one.
           */
-          best_node = curr_nodes.back();
+          best_node = worklists.pop_spill_candidate();
         }
         stack.push_back(best_node);
-        graph->removeNode(best_node);
+        worklists.remove(best_node);
       }
 
       /*
@@ -154,33 +205,11 @@ namespace L2 {
         Node* node = node_stack.back();
         node_stack.pop_back();
 
-        /*
-        Get a set of the current node's neighbors from the original cloned state
-        */
-        std::set<Node*> full_neighbor_set;
-        auto curr_node_in_original_graph_iterator = g->nodes.find(node->var);
-        if (curr_node_in_original_graph_iterator != g->nodes.end()) {
-          Node* n = curr_node_in_original_graph_iterator->second;
-          auto full_neighbor_set_iterator = g->graph.find(n);
-          if (full_neighbor_set_iterator != g->graph.end()) {
-              full_neighbor_set = full_neighbor_set_iterator->second;
-          } else {
-              if (debug) std::cerr << "Couldn't find this node in the original graph.\n";
-          }
-        } else {
-            if (debug) std::cerr << "Couldn't find this varianble in any of the original graph's nodes.\n";
-        }
-
         /*
         Get a vector of the current node's original neighbors which exist in the current state of the graph.
+        - the copy still holds every edge of the original graph, so it can answer this directly.
         */
-        std::vector<Node*> neighbors_in_curr_graph;
-        for (auto n : full_neighbor_set) {
-          auto curr_graph_node_iterator = g_copy->nodes.find(n->var);
-          if (curr_graph_node_iterator != g_copy->nodes.end()) {
-              neighbors_in_curr_graph.push_back(curr_graph_node_iterator->second);
-          }
-        }
+        std::vector<Node*> neighbors_in_curr_graph = g_copy->getNeighbors(node);
 
         /*
         Using the above vector, create a set of the colors belonging to the neighbors of the current node, 
@@ -232,7 +261,7 @@ namespace L2 {
         /*
         Add the node back into the graph (if it wasn't able to be colored, then it still has an empty string and we spill)
         */
-        add_back_into_graph(node, neighbors_in_curr_graph, g_copy);
+        add_back_into_graph(node, g_copy);
       }
       /*
       We know we failed the big condition and have to spill everything if:
@@ -246,11 +275,8 @@ namespace L2 {
     }
 
 
-  void add_back_into_graph(Node* node, std::vector<Node*> neighbors, Graph* g) {
-    g->addNode(node);
-    for (auto neighbor : neighbors) {
-      g->addEdge(node, neighbor);
-    }
+  void add_back_into_graph(Node* node, Graph* g) {
+    g->restoreNode(node);
   }
 
 
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <queue>
+
 #include "L2.h"
 #include "interference_graph.h"
 
 namespace L2 {
 
+    /*
+    The colors we can hand out, in the order the coloring tries them.
+    */
+    extern const std::vector<std::string> gp_registers;
+
     /*
     The main graph coloring function.
     Inputs:
@@ -25,6 +32,36 @@ namespace L2 {
     */
     void color_registers(Graph *g);
 
+    /*
+    Simplify worklists used by depopulate. Every variable node still in the graph sits in the bucket for its current degree:
+    - buckets below the number of colors make up the low-degree worklist, the rest the spill-candidate worklist.
+    - buckets are intrusive doubly linked lists indexed by node id, so moving a node when a neighbor leaves is O(1).
+    - spill candidates also sit in a min-heap on spill cost / degree; entries go stale when the node's degree changes
+      and are skipped when popped.
+    */
+    class DegreeWorklists {
+      public:
+        DegreeWorklists(Graph *graph, int64_t colors);
+        bool empty() const;
+        Node* pop_low_degree();         // highest degree node below the number of colors, nullptr if there is none
+        Node* pop_spill_candidate();    // cheapest node to spill: lowest spill cost / degree
+        void remove(Node *node);        // takes a popped node out of the graph and re-buckets its neighbors
+
+      private:
+        void link(int64_t id, int64_t degree);
+        void unlink(int64_t id);
+        Graph *graph;
+        int64_t colors;
+        int64_t count;
+        int64_t max_degree;
+        std::vector<int64_t> bucket_head;
+        std::vector<int64_t> next;
+        std::vector<int64_t> prev;
+        std::vector<int64_t> bucket_of;     // -1 if the node isn't in any bucket (registers, or already popped)
+        std::priority_queue<std::tuple<double, int64_t, int64_t>, std::vector<std::tuple<double, int64_t, int64_t>>,
+            std::greater<std::tuple<double, int64_t, int64_t>>> spill_candidates;  // (cost / degree, -degree, id)
+    };
+
     /*
     Repeatedly takes out nodes from the graph and return them in a stack
     */
@@ -36,9 +73,9 @@ namespace L2 {
     std::tuple<bool, std::vector<Node*>> repopulate(Graph *graph, Graph *graph_copy, std::vector<Node*> node_stack);
 
     /*
-    Places edges between a given node and its neighbors described in the vector arg 
+    Places a removed node back into the graph, reconnecting it with its neighbors that are currently in the graph
     */
-    void add_back_into_graph(Node* node, std::vector<Node*> neighbors, Graph* g);
+    void add_back_into_graph(Node* node, Graph* g);
 
     /*
     Parses an L2 interference graph file into a graph memory representation
@@ -4,7 +4,7 @@ namespace L2 {
 
     // list of general purpose registors for convenience,
     // manually sorted according to the slides
-    std::vector<std::string> gp_registers_alt{
+    const std::vector<std::string> gp_registers_alt{
         "r10",
         "r11",
         "r8",
@@ -68,33 +68,10 @@ namespace L2 {
             //     continue;
             // }
 
-            /*
-            Get a set of the current node's neighbors from the original cloned state
-            */
-            std::set<Node*> full_neighbor_set;
-            auto curr_node_in_original_graph_iterator = graph->nodes.find(curr_node->var);
-            if (curr_node_in_original_graph_iterator != graph->nodes.end()) {
-                Node* n = curr_node_in_original_graph_iterator->second;
-                auto full_neighbor_set_iterator = graph->graph.find(n);
-                if (full_neighbor_set_iterator != graph->graph.end()) {
-                    full_neighbor_set = full_neighbor_set_iterator->second;
-                } else {
-                    if (debug) std::cerr << "Couldn't find this node in the original graph.\n";
-                }
-            } else {
-                if (debug) std::cerr << "Couldn't find this variable in any of the original graph's nodes.\n";
-            }
-
             /*
             Get a vector of the current node's original neighbors which exist in the current state of the graph.
             */
-            std::vector<Node*> neighbors_in_curr_graph;
-            for (auto n : full_neighbor_set) {
-                auto curr_graph_node_iterator = graph_copy->nodes.find(n->var);
-                if (curr_graph_node_iterator != graph_copy->nodes.end()) {
-                    neighbors_in_curr_graph.push_back(curr_graph_node_iterator->second);
-                }
-            }
+            std::vector<Node*> neighbors_in_curr_graph = graph_copy->getNeighbors(curr_node);
 
             /*
             Here, node has not been colored. We look for the best color we are allowed to assign it.
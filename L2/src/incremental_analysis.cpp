@@ -0,0 +1,217 @@
+#include <limits>
+
+#include "incremental_analysis.h"
+
+using namespace std;
+
+namespace L2 {
+
+    Graph* update_analysis_after_spill(Function *fptr, Curr_F_Liveness &liveness, Graph *graph,
+        const std::vector<SpillRewrite> &rewrites, const std::vector<Variable*> &spilled) {
+      std::set<std::string> spilled_names;
+      for (auto var : spilled) {
+        spilled_names.insert(var->name);
+      }
+
+      /*
+      Lay the old positions over the rewritten function: old instruction p now spans [start[p], start[p + 1]),
+      its reloads first, then itself (unless it was dropped), then its stores.
+      */
+      int64_t old_count = liveness.gen.size();
+      std::vector<const SpillRewrite*> rewrite_at(old_count, nullptr);
+      for (auto& rewrite : rewrites) {
+        if (rewrite.position < 0 || rewrite.position >= old_count) return nullptr;
+        rewrite_at[rewrite.position] = &rewrite;
+      }
+      std::vector<int64_t> start(old_count + 1, 0);
+      int64_t cursor = 0;
+      for (int64_t p = 0; p < old_count; p++) {
+        start[p] = cursor;
+        auto rewrite = rewrite_at[p];
+        cursor += rewrite ? rewrite->before.size() + (rewrite->dropped ? 0 : 1) + rewrite->after.size() : 1;
+      }
+      start[old_count] = cursor;
+      if (cursor != (int64_t)fptr->instructions.size()) return nullptr;
+
+      /*
+      The spilled variables' ids become unused, the temporaries get new ids after the existing ones.
+      */
+      size_t old_width = liveness.variables.size();
+      BitVector spilled_ids(old_width);
+      for (size_t id = 0; id < old_width; id++) {
+        if (spilled_names.count(liveness.variables[id]->name)) spilled_ids.set(id);
+      }
+      for (auto& rewrite : rewrites) {
+        for (auto temporaries : {&rewrite.before, &rewrite.after}) {
+          for (auto temporary : *temporaries) {
+            if (liveness.variable_ids.count(temporary)) continue;
+            liveness.variable_ids[temporary] = liveness.variables.size();
+            liveness.variables.push_back(temporary);
+          }
+        }
+      }
+      size_t width = liveness.variables.size();
+
+      /*
+      The graph loses the spilled nodes in place: the others keep their Node (and with it their spill cost, their
+      references did not change) and are renumbered in order. The colorer worked on a clone, only the per-coloring
+      state is reset. Edges are laid out again in the order addEdge would give a graph built from scratch.
+      */
+      Graph *patched = graph;
+      patched->spilled_vars = fptr->spilled_variables;
+      patched->spill_vars = fptr->spill_variables_set;
+      int64_t old_nodes = patched->node_list.size();
+      std::vector<int64_t> kept(old_nodes, -1);
+      int64_t node_count = 0;
+      for (int64_t id = 0; id < old_nodes; id++) {
+        Node *node = patched->node_list[id];
+        if (!as_register(node->var) && spilled_names.count(node->var->name)) {
+          patched->nodes.erase(node->var);
+          continue;
+        }
+        kept[id] = node_count;
+        node->id = node_count;
+        node->degree = 0;
+        node->color = "";
+        node->removed = false;
+        patched->node_list[node_count++] = node;
+      }
+      patched->node_list.resize(node_count);
+      patched->size = node_count;
+      std::vector<std::vector<int64_t>> old_adjacency;
+      old_adjacency.swap(patched->adjacency);
+      patched->adjacency.resize(node_count);
+      patched->matrix.assign((node_count * (node_count - 1) / 2 + 63) / 64, 0);
+      for (int64_t id = 0; id < old_nodes; id++) {
+        if (kept[id] < 0) continue;
+        for (auto neighbor_id : old_adjacency[id]) {
+          if (neighbor_id < id && kept[neighbor_id] >= 0) {
+            patched->addEdge(patched->node_list[kept[id]], patched->node_list[kept[neighbor_id]]);
+          }
+        }
+      }
+
+      std::vector<Node*> id_nodes(width, nullptr);
+      for (size_t id = 0; id < width; id++) {
+        Variable *var = liveness.variables[id];
+        if (id >= old_width) patched->addNode(new Node(var));
+        auto it = patched->nodes.find(var);
+        if (it != patched->nodes.end()) id_nodes[id] = it->second;
+      }
+      auto connect = [&](Node *node, const BitVector &live) {
+        live.for_each([&](size_t id) {
+          if (id_nodes[id]) patched->addEdge(node, id_nodes[id]);
+        });
+      };
+
+      std::vector<Node*> registers_but_rcx;
+      for (auto register_name : gp_registers) {
+        if (register_name == "rcx") continue;
+        Variable *reg = fptr->variable_allocator.allocate_variable(register_name, VariableType::reg);
+        auto it = patched->nodes.find(reg);
+        if (it != patched->nodes.end()) registers_but_rcx.push_back(it->second);
+      }
+
+      /*
+      Edges of the temporaries, from the old sets of their instruction (still describing the function before the spill).
+      - a reloaded temporary is live from its reload into the instruction: it meets In minus the spilled variables,
+        and the other reloaded temporaries.
+      - a stored temporary is live from the instruction to its store: it meets Out and Kill minus the spilled
+        variables, and the other stored temporaries.
+      */
+      for (auto& rewrite : rewrites) {
+        if (rewrite.dropped) continue;
+        int64_t p = rewrite.position;
+        BitVector in = liveness.in(p);
+        BitVector out = liveness.out(p);
+        out.union_with(liveness.kill[p]);
+        in.subtract(spilled_ids);
+        out.subtract(spilled_ids);
+        for (auto temporary : rewrite.before) {
+          Node *node = patched->nodes[temporary];
+          connect(node, in);
+          for (auto other : rewrite.before) patched->addEdge(node, patched->nodes[other]);
+        }
+        for (auto temporary : rewrite.after) {
+          Node *node = patched->nodes[temporary];
+          connect(node, out);
+          for (auto other : rewrite.after) patched->addEdge(node, patched->nodes[other]);
+        }
+
+        /*
+        Same rule as build_graph: a shift amount held in a variable can only be in rcx.
+        */
+        Instruction *iptr = fptr->instructions[start[p] + rewrite.before.size()];
+        auto source = (iptr->kind == InstructionKind::sop) ? as_variable(static_cast<SOP_assignment*>(iptr)->src) : nullptr;
+        if (source && patched->nodes.count(source) && std::find(rewrite.before.begin(), rewrite.before.end(), source) != rewrite.before.end()) {
+          for (auto reg : registers_but_rcx) patched->addEdge(patched->nodes[source], reg);
+        }
+      }
+
+      /*
+      Liveness of the rewritten function: same blocks (now covering the reloads and stores), same block In/Out sets,
+      gen/kill of the rewritten instructions with the spilled variables renamed to their temporaries.
+      */
+      std::vector<BitVector> gen(cursor, BitVector(width));
+      std::vector<BitVector> kill(cursor, BitVector(width));
+      for (int64_t p = 0; p < old_count; p++) {
+        auto rewrite = rewrite_at[p];
+        int64_t position = start[p];
+        if (!rewrite) {
+          gen[position] = std::move(liveness.gen[p]);
+          kill[position] = std::move(liveness.kill[p]);
+          gen[position].grow(width);
+          kill[position].grow(width);
+          continue;
+        }
+        for (auto temporary : rewrite->before) {
+          kill[position++].set(liveness.variable_ids[temporary]);
+        }
+        if (!rewrite->dropped) {
+          gen[position] = std::move(liveness.gen[p]);
+          kill[position] = std::move(liveness.kill[p]);
+          gen[position].grow(width);
+          kill[position].grow(width);
+          gen[position].subtract(spilled_ids);
+          kill[position].subtract(spilled_ids);
+          for (auto temporary : rewrite->before) gen[position].set(liveness.variable_ids[temporary]);
+          for (auto temporary : rewrite->after) kill[position].set(liveness.variable_ids[temporary]);
+          position++;
+        }
+        for (auto temporary : rewrite->after) {
+          gen[position++].set(liveness.variable_ids[temporary]);
+        }
+      }
+      liveness.gen = std::move(gen);
+      liveness.kill = std::move(kill);
+
+      int64_t block_count = liveness.block_first.size();
+      liveness.block_of.assign(cursor, 0);
+      for (int64_t b = 0; b < block_count; b++) {
+        liveness.block_first[b] = start[liveness.block_first[b]];
+        liveness.block_last[b] = start[liveness.block_last[b] + 1] - 1;
+        for (int64_t i = liveness.block_first[b]; i <= liveness.block_last[b]; i++) {
+          liveness.block_of[i] = b;
+        }
+        liveness.block_in[b].grow(width);
+        liveness.block_out[b].grow(width);
+        liveness.block_in[b].subtract(spilled_ids);
+        liveness.block_out[b].subtract(spilled_ids);
+      }
+      liveness.instruction_in.assign(cursor, BitVector());
+      liveness.instruction_out.assign(cursor, BitVector());
+      liveness.block_expanded.assign(block_count, false);
+
+      /*
+      The temporaries are the only new nodes, and a temporary is never spilled again (compute_spill_costs' rule).
+      */
+      for (size_t id = old_width; id < width; id++) {
+        if (id_nodes[id]) id_nodes[id]->spill_cost = std::numeric_limits<double>::infinity();
+      }
+
+      if (debug) std::cerr << "patched the analysis of " << fptr->name << " after spilling " << spilled_names.size()
+          << " variables (" << rewrites.size() << " instructions rewritten)" << std::endl;
+      return patched;
+    }
+
+}
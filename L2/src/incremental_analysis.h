@@ -0,0 +1,32 @@
+#pragma once
+
+#include "L2.h"
+#include "interference_graph.h"
+
+namespace L2 {
+
+    struct Curr_F_Liveness;
+    struct SpillRewrite;
+
+    /*
+    Brings the analysis of a function up to date after spill_variables, without redoing it.
+    - a spill temporary only lives between its reload and its instruction, or between its instruction and its store,
+      so the liveness of everything else is the old one minus the spilled variables, and every block keeps its
+      In/Out sets. Only the gen/kill sets of the rewritten instructions change; blocks are re-expanded lazily.
+    - the new interference graph is the old one without the spilled nodes, plus one node per temporary with the
+      edges it gets at its own instruction: what is live into it for a reload, what is live out of it (and what it
+      kills) for a store.
+    - liveness is updated in place to describe the rewritten function, ready for the next round.
+    - spill costs are not recomputed: the kept nodes have the same references as before and the temporaries can't
+      be spilled. spill_variables has already brought the use/def tables up to date.
+    - what is still linear in the size of the function per round: renumbering the graph (O(V + E), the same as the
+      clone the colorer takes every round) and the position indexed gen/kill/block_of arrays (O(n)), since every
+      position after the first rewrite moves.
+
+    Returns nullptr if the rewrites don't match the function, the caller then falls back to analyze_L2.
+    The graph passed in is the one patched and returned.
+    */
+    Graph* update_analysis_after_spill(Function *fptr, Curr_F_Liveness &liveness, Graph *graph,
+        const std::vector<SpillRewrite> &rewrites, const std::vector<Variable*> &spilled);
+
+}
@@ -2,7 +2,7 @@
 #include "interference_graph.h"
 
 namespace L2{
-  Node::Node(Variable *var) : var(var), degree(0), color("") {
+  Node::Node(Variable *var) : var(var), degree(0), color(""), id(-1), removed(false), spill_cost(0) {
   }
 
   u_int64_t Node::getDegree(void) const {
@@ -23,10 +23,17 @@ namespace L2{
         return;
     }
 
-    // If the node doesn't exist, add it to the graph with no connections initially.
-    graph[node] = std::set<Node*>();
+    // If the node doesn't exist, give it the next dense id with no connections initially.
+    node->id = node_list.size();
+    node->removed = false;
+    node_list.push_back(node);
+    adjacency.emplace_back();
     nodes[node->get()] = node; // Associate the Variable with the node here
 
+    // Grow the triangular matrix by the new row (one bit per existing node)
+    size_t rows = node_list.size();
+    matrix.resize((rows * (rows - 1) / 2 + 63) / 64, 0);
+
     // Update the graph size
     size++;
 }
@@ -34,41 +41,39 @@ namespace L2{
 
   void Graph::removeNode(Node *node) {
     /*
-    Iterate over all other nodes in the graph to handle if the given node is a neighbor to any of them.
+    Take the node out of the graph: only the neighbors still in the graph lose a degree.
+    The edges stay in the matrix/adjacency so restoreNode can put the node back as it was.
     */
-    std::vector<Node*> nodes_vec = getNodes();
-    for (auto& other_node : nodes_vec) {
-      auto it = graph.find(other_node);
-      if (it != graph.end()) {
-        /*
-        go about erasing the current node from the other node's neighbors set
-        */
-        if (it->second.erase(node)) {
-          /*
-          the current node and the other node were neighbors, so we need to remove their edge.
-          */
-          it->first->addDegree(-1);
-          node->addDegree(-1);
-        }
-      } else {
-        if (debug) std::cerr << "something is probably wrong, couldn't find a node returned by getNodes() in the graph.\n";
+    if (node->removed) {
+      return;
+    }
+    for (auto neighbor_id : adjacency[node->id]) {
+      Node* other_node = node_list[neighbor_id];
+      if (!other_node->removed) {
+        other_node->addDegree(-1);
+        node->addDegree(-1);
       }
-      /*
-      This isn't strictly necessary since we will end up just removing the current node entirely from the graph,
-      but we can also update its neighbors dictionary for debugging. Do this later.
-      */
-     
-      // ...
     }
+    node->removed = true;
+    size--;
+  }
 
+  void Graph::restoreNode(Node *node) {
     /*
-    Remove the node itself.
-    - Should we also free the node's memory? we probably could, since the original copy of the
-    node still lays outside of the depopulate function.
+    Inverse of removeNode, reconnects the node with every neighbor currently in the graph.
     */
-    graph.erase(node);
-    nodes.erase(node->get());
-    size--;
+    if (!node->removed) {
+      return;
+    }
+    node->removed = false;
+    for (auto neighbor_id : adjacency[node->id]) {
+      Node* other_node = node_list[neighbor_id];
+      if (!other_node->removed) {
+        other_node->addDegree(1);
+        node->addDegree(1);
+      }
+    }
+    size++;
   }
 
   void Graph::removeNodeByName(const std::string& varName) {
@@ -81,6 +86,17 @@ namespace L2{
       }
   }
 
+  bool Graph::hasEdge(int64_t a, int64_t b) const {
+    if (a == b) {
+      return false;
+    }
+    if (a < b) {
+      std::swap(a, b);
+    }
+    uint64_t bit = (uint64_t)a * (a - 1) / 2 + b;
+    return (matrix[bit >> 6] >> (bit & 63)) & 1;
+  }
+
   void Graph::addEdge(Node *src, Node *dst) {
     // Check for null pointers before using them
     if (!src || !dst) {
@@ -88,100 +104,120 @@ namespace L2{
         return; // Optionally, throw an exception or handle the error as appropriate
     }
 
-    if (graph[src].find(dst) == graph[src].end()) {
-      // Now it's safe to use src and dst
-      graph[src].insert(dst);
-      graph[dst].insert(src);
-
-      // Check that the nodes exist before calling member functions
-      if (src) {
-          src->addDegree(1);
-      }
-      if (dst) {
-          dst->addDegree(1);
-      }
+    if (src == dst || hasEdge(src->id, dst->id)) {
+      return;
+    }
+    int64_t a = std::max(src->id, dst->id);
+    int64_t b = std::min(src->id, dst->id);
+    uint64_t bit = (uint64_t)a * (a - 1) / 2 + b;
+    matrix[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    adjacency[src->id].push_back(dst->id);
+    adjacency[dst->id].push_back(src->id);
+
+    // Degrees only count neighbors that are both currently in the graph
+    if (!src->removed && !dst->removed) {
+      src->addDegree(1);
+      dst->addDegree(1);
     }
-
   }
 
   void Graph::removeEdge(Node *src, Node *dst) {
-    // assumes that an edge between src and dst exists, but check for null ptrs
+    // check for null ptrs, and that the edge actually exists
     if (!src || !dst) {
       std::cerr << "Error: null pointer passed to addEdge" << std::endl;
       return; // Optionally, throw an exception or handle the error as appropriate
     }
+    if (!hasEdge(src->id, dst->id)) {
+      return;
+    }
 
-    // remove the dst node from the src's node set of neighbors and vice versa
-    graph[src].erase(dst);
-    graph[dst].erase(src);
+    // clear the matrix bit and drop each node from the other's adjacency vector
+    int64_t a = std::max(src->id, dst->id);
+    int64_t b = std::min(src->id, dst->id);
+    uint64_t bit = (uint64_t)a * (a - 1) / 2 + b;
+    matrix[bit >> 6] &= ~((uint64_t)1 << (bit & 63));
+    auto& src_adjacency = adjacency[src->id];
+    src_adjacency.erase(std::find(src_adjacency.begin(), src_adjacency.end(), dst->id));
+    auto& dst_adjacency = adjacency[dst->id];
+    dst_adjacency.erase(std::find(dst_adjacency.begin(), dst_adjacency.end(), src->id));
 
     // update the respective degrees
-    src->addDegree(-1);
-    dst->addDegree(-1);
+    if (!src->removed && !dst->removed) {
+      src->addDegree(-1);
+      dst->addDegree(-1);
+    }
   }
 
   bool Graph::exists(Variable *var) {
-    // Check if a node for the variable exists in the graph.
-    return nodes.find(var) != nodes.end();
+    // Check if a node for the variable exists in the graph (and hasn't been removed).
+    auto it = nodes.find(var);
+    return it != nodes.end() && !it->second->removed;
   }
 
   std::vector<Node *> Graph::getNodes(void) const {
-    // Return a vector of all the nodes in the graph.
+    // Return a vector of all the nodes currently in the graph, in id order.
     std::vector<Node *> nodeVec;
-    for (const auto &pair : graph) {
-      nodeVec.push_back(pair.first);
+    for (auto node : node_list) {
+      if (!node->removed) {
+        nodeVec.push_back(node);
+      }
     }
     return nodeVec;
   }
 
   std::vector<Node *> Graph::getVarNodes(void) const {
     /*
-    Return a vector of all non-register nodes in the graph.
+    Return a vector of all non-register nodes currently in the graph.
     */
     std::vector<Node *> nodeVec;
-    for (const auto &pair : nodes) {
-      auto reg_ptr = dynamic_cast<Register*>(pair.first);
+    for (auto node : node_list) {
+      if (node->removed) {
+        continue;
+      }
+      auto reg_ptr = dynamic_cast<Register*>(node->var);
       if (!reg_ptr) {
-        nodeVec.push_back(pair.second);
+        nodeVec.push_back(node);
       }
     }
     return nodeVec;
   }
 
-  Graph * Graph::clone(void) const {
-    // Create a new graph instance.
-    auto newGraph = new Graph();
+  std::vector<Node *> Graph::getNeighbors(Node *node) const {
+    /*
+    Return the node's neighbors that are currently in the graph.
+    */
+    std::vector<Node *> nodeVec;
+    for (auto neighbor_id : adjacency[node->id]) {
+      Node* neighbor = node_list[neighbor_id];
+      if (!neighbor->removed) {
+        nodeVec.push_back(neighbor);
+      }
+    }
+    return nodeVec;
+  }
 
+  Graph * Graph::clone(void) const {
     /*
-    Make sure to transfer over all the original graph's spill variable set
+    Ids are shared between the two graphs, so the edge matrix and adjacency vectors are copied wholesale,
+    only the Node objects (which carry per-graph color/degree/removed state) are recreated.
     */
+    auto newGraph = new Graph();
     newGraph->spill_vars = spill_vars;
-
-    std::map<const Node*, Node*> origToNewNodeMap;
-
-    for (const auto &nodePair : this->nodes) {
-      Variable *var = nodePair.first;
-      const Node *origNode = nodePair.second;
-      // Create a new node with the same variable.
-      Node *newNode = new Node(var);
-      // You may want to copy the color or other attributes of Node here.
+    newGraph->spilled_vars = spilled_vars;
+    newGraph->size = size;
+    newGraph->adjacency = adjacency;
+    newGraph->matrix = matrix;
+    newGraph->node_list.reserve(node_list.size());
+    newGraph->nodes.reserve(node_list.size());
+    for (auto origNode : node_list) {
+      Node *newNode = new Node(origNode->var);
       newNode->color = origNode->color;
-      // Add the new node to the new graph.
-      newGraph->addNode(newNode);
-      // Store it in the map.
-      origToNewNodeMap[origNode] = newNode;
-    }
-
-    // Copy edges.
-    for (const auto &edgePair : this->graph) {
-      const Node *origNode = edgePair.first;
-      for (const Node *connectedNode : edgePair.second) {
-        // Find the corresponding new nodes.
-        Node *newNode = origToNewNodeMap[origNode];
-        Node *newConnectedNode = origToNewNodeMap[connectedNode];
-        // Add the edge between the new nodes in the new graph.
-        newGraph->addEdge(newNode, newConnectedNode);
-      }
+      newNode->degree = origNode->degree;
+      newNode->id = origNode->id;
+      newNode->removed = origNode->removed;
+      newNode->spill_cost = origNode->spill_cost;
+      newGraph->node_list.push_back(newNode);
+      newGraph->nodes[newNode->var] = newNode;
     }
 
     return newGraph;
@@ -191,13 +227,14 @@ namespace L2{
   //   // Return the size of the graph, i.e., the number of nodes.
   //   return graph.size();
   // }
-  void add_new_var(Graph *graph,std::set<Variable*>gen_kill_sets){
-    for (auto variable: gen_kill_sets){
+  void add_new_var(Graph *graph, const BitVector &gen_kill_sets, const std::vector<Variable*> &variables){
+    gen_kill_sets.for_each([&](size_t id) {
+      Variable* variable = variables[id];
       if (graph->exists(variable)){
-        continue;
+        return;
       }
       graph->addNode(new Node(variable));
-    }
+    });
     return;
   }
   void add_edges_var(Graph *graph,std::set<Variable*>in_out_sets){
@@ -210,14 +247,26 @@ namespace L2{
       }
     }
   }
+  void add_edges_var(Graph *graph, const BitVector &in_out_sets, const std::vector<Node*> &id_nodes){
+    std::vector<Node*> clique;
+    in_out_sets.for_each([&](size_t id) {
+      clique.push_back(id_nodes[id]);
+    });
+    for (size_t a = 0; a < clique.size(); a++){
+      for (size_t b = a + 1; b < clique.size(); b++){
+        graph->addEdge(clique[a], clique[b]);
+      }
+    }
+  }
   void Graph::printGraph() const {
-    for (const auto& node_pair : graph) {
-        if (node_pair.first && node_pair.first->var) {
-            // Print the name of the root node
-            std::cout << node_pair.first->var->print();
+    for (auto node : node_list) {
+        if (node->removed || !node->var) {
+            continue;
         }
-        for (const auto& connected_node : node_pair.second) {
-            if (connected_node && connected_node->var) {
+        // Print the name of the root node
+        std::cout << node->var->print();
+        for (auto connected_node : getNeighbors(node)) {
+            if (connected_node->var) {
                 // Print the connected nodes
                 std::cout << " " << connected_node->var->print();
             }
@@ -227,7 +276,7 @@ namespace L2{
   }
   // Graph* Graph::build_graph(Program &p, LivenessResult result ){
   // Graph* build_graph(Program &p, LivenessResult result){
-  Graph* build_graph(Function *f, Curr_F_Liveness result) {
+  Graph* build_graph(Function *f, Curr_F_Liveness &result) {
     auto interference_graph = new Graph();
 
     /*
@@ -237,11 +286,6 @@ namespace L2{
     interference_graph->spilled_vars = f->spilled_variables;
     interference_graph->spill_vars = f->spill_variables_set;
 
-    /*
-    Initialize the graph's size metric.
-    */
-    interference_graph->size = 0;
-
     std::set<Variable *> registers;
     // gp registers vector
     std::vector<std::string> gp_registers{
@@ -268,39 +312,40 @@ namespace L2{
         Node* node = new Node(var); // Assuming Node constructor takes a Variable*
         interference_graph->addNode(node);
     }
-    for (auto i : f->instructions){
-        // add_new_var(interference_graph,gen_kill_set.Gen_Set[0][i]);//hopefully this doesn't cause an error later on 
-        // add_new_var(interference_graph,gen_kill_set.Kill_Set[0][i]);
-        add_new_var(interference_graph, result.gen[i]);
-        add_new_var(interference_graph, result.kill[i]);
+    size_t instruction_count = f->instructions.size();
+    for (size_t i = 0; i < instruction_count; i++){
+        add_new_var(interference_graph, result.gen[i], result.variables);
+        add_new_var(interference_graph, result.kill[i], result.variables);
+    }
+    /*
+    Map each dense liveness id to its node so the bit vectors can be turned into edges directly.
+    */
+    std::vector<Node*> id_nodes(result.variables.size(), nullptr);
+    for (size_t id = 0; id < result.variables.size(); id++){
+        id_nodes[id] = interference_graph->nodes[result.variables[id]];
     }
     //add nodes and connect variables in Kill[i] with those in OUT[i]
-    for (auto i : f->instructions){
-        // add_edges_var(interference_graph,in_out_sets.In_Set[0][i]);
-        // add_edges_var(interference_graph,in_out_sets.Out_Set[0][i]);
-        add_edges_var(interference_graph, result.in[i]);
-        add_edges_var(interference_graph, result.out[i]);
-        std::set<Variable *> insert_set;
-        // insert_set.insert(gen_kill_set.Kill_Set[0][i].begin(),gen_kill_set.Kill_Set[0][i].end());
-        // insert_set.insert(in_out_sets.Out_Set[0][i].begin(),in_out_sets.Out_Set[0][i].end());
-        insert_set.insert(result.kill[i].begin(), result.kill[i].end());
-        insert_set.insert(result.out[i].begin(), result.out[i].end());
-        add_edges_var(interference_graph, insert_set);
+    for (size_t i = 0; i < instruction_count; i++){
+        add_edges_var(interference_graph, result.in(i), id_nodes);
+        add_edges_var(interference_graph, result.out(i), id_nodes);
+        BitVector insert_set = result.kill[i];
+        insert_set.union_with(result.out(i));
+        add_edges_var(interference_graph, insert_set, id_nodes);
     }
     add_edges_var(interference_graph, registers);
     for (auto i: f->instructions){
-      auto checker = dynamic_cast<SOP_assignment*>(i);
-      if (!i ||! checker){
+      if (!i || i->kind != InstructionKind::sop){
         continue;
       }
-      auto source_variable = dynamic_cast<Variable*>(checker->src);
+      auto checker = static_cast<SOP_assignment*>(i);
+      auto source_variable = as_variable(checker->src);
       if (!source_variable){
         continue;
       }
       std::set<Variable*> register_insertions;
       register_insertions.insert(registers.begin(),registers.end());
       for (auto variable:registers){
-        auto checking_register = dynamic_cast<Register *>(variable);
+        auto checking_register = as_register(variable);
         if (checking_register->name != "rcx"){
           continue;
         }
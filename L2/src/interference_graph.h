@@ -3,6 +3,11 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "arena.h"
 
 // #include <L2.h>
 // #include <graph_coloring.h>
@@ -16,32 +21,46 @@ namespace L2{
     struct Curr_F_Liveness;
 
     // Declare a r
-    class Node{
+    class Node : public ArenaAllocated<Node> {
         public:
             Node (Variable *var);
             u_int64_t getDegree(void) const;
             Variable* get(void) const;
             void addDegree(int64_t delta);
             Variable *var; 
-            int64_t degree;
+            int64_t degree;         // number of neighbors currently in the graph
             std::string color;
+            int64_t id;             // dense index of the node inside its graph
+            bool removed;           // set while the node is taken out by removeNode
+            double spill_cost;      // loop weighted use/def count, see compute_spill_costs
     };
-    // Generic class declarations for nodes and graph
-    class Graph{
+    /*
+    Interference graph.
+    - every node gets a dense id when it is added; ids index node_list, adjacency and the edge matrix.
+    - edges live in a triangular bit matrix (O(1) edge queries) and in per-node adjacency vectors (fast neighbor walks).
+    - removeNode/restoreNode only flip the node's removed flag and fix up degrees, the edges themselves never move,
+      so the full neighborhood of a removed node is still available when it is put back.
+    */
+    class Graph : public ArenaAllocated<Graph> {
         public:
-            std::map<Node *,std::set<Node *>> graph;
-            std::map<Variable *, Node *> nodes;
+            std::vector<Node *> node_list;
+            std::vector<std::vector<int64_t>> adjacency;
+            std::vector<uint64_t> matrix;
+            std::unordered_map<Variable *, Node *> nodes;
             std::set<Variable *> spilled_vars;
             std::set<Variable *> spill_vars;
-            int32_t size;
+            int32_t size = 0;
             void addNode(Node *node);
             void removeNode(Node *node);
+            void restoreNode(Node *node);
             void addEdge(Node *src, Node *dst);
             void removeEdge(Node *src, Node *dst);
+            bool hasEdge(int64_t a, int64_t b) const;
             void removeNodeByName(const std::string& varName);
             bool exists(Variable *var);
             std::vector<Node *> getNodes(void) const;
             std::vector<Node *> getVarNodes(void) const;
+            std::vector<Node *> getNeighbors(Node *node) const;
             Graph * clone(void) const; //If we ever need to make a clone
             int32_t getSize();
             // int32_t size(void);
@@ -52,7 +71,7 @@ namespace L2{
     };
     
     // Graph * build_graph(Program &p, LivenessResult result);
-    Graph * build_graph(Function *f, Curr_F_Liveness result);
+    Graph * build_graph(Function *f, Curr_F_Liveness &result);
     
     std::set<std::string> get_colors(std::vector<Node*> nodes);
 
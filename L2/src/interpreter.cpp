@@ -14,39 +14,80 @@
 
 #include <parser.h>
 #include <code_generator.h>
+#include <execution.h>
 
 using namespace std;
 
 void print_help (char *progName){
-  std::cerr << "Usage: " << progName << " SOURCE" << std::endl;
+  std::cerr << "Usage: " << progName << " [-a] [-O 0|1|2|3] [-c] SOURCE" << std::endl;
   return ;
 }
 
 int main(
-  int argc, 
+  int argc,
   char **argv
   ){
-  auto enable_code_generator = false;
-  int32_t optLevel = 0;
-  bool verbose;
+  int32_t optLevel = 2;
+  auto allocate = false;
+  auto counters = false;
 
-  /* 
-   * Check the compiler arguments.
+  /*
+   * Check the interpreter arguments.
    */
   if( argc < 2 ) {
     print_help(argv[0]);
     return 1;
   }
+  int32_t opt;
+  while ((opt = getopt(argc, argv, "aO:c")) != -1) {
+    switch (opt){
+
+      case 'a':
+        allocate = true;
+        break ;
+
+      case 'O':
+        optLevel = strtoul(optarg, NULL, 0);
+        break ;
+
+      case 'c':
+        counters = true;
+        break ;
+
+      default:
+        print_help(argv[0]);
+        return 1;
+    }
+  }
+
+  /*
+   * The parsed program (and, with -a, its allocated functions) lives as long as the run.
+   */
+  L2::Arena program_arena;
+  L2::ArenaScope program_scope(&program_arena);
 
   /*
    * Parse the input file.
    */
   auto p = L2::parse_file(argv[optind]);
 
+  /*
+   * -a: run the functions the way the compiler hands them to L1, with registers and stack slots allocated.
+   */
+  if (allocate) {
+    for (size_t i = 0; i < p.functions.size(); i++) {
+      p.functions[i] = L2::allocate_registers(p.functions[i], optLevel);
+    }
+  }
+
   /*
    * Interpret the L2 program.
+   * -c: what every function executed, as JSON on stderr so the program's own output stays comparable.
    */
-  //TODO
+  L2::Interpreter interpreter(p, allocate);
+  int status = interpreter.run();
+  std::cout.flush();
+  if (counters) L2::print_execution_report(std::cerr, interpreter);
 
-  return 0;
+  return status;
 }
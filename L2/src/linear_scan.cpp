@@ -0,0 +1,183 @@
+#include "linear_scan.h"
+
+using namespace std;
+
+namespace L2 {
+
+    std::tuple<bool, std::vector<Variable*>> linear_scan(Function *fptr) {
+      Curr_F_Liveness liveness = liveness_analysis(fptr);
+      int64_t n = fptr->instructions.size();
+      int64_t colors = gp_registers.size();
+      int64_t width = liveness.variables.size();
+
+      /*
+      Split the numbered variables into physical registers and intervals (one per variable name).
+      */
+      std::vector<int64_t> register_of(width, -1);
+      std::vector<int64_t> interval_of(width, -1);
+      std::vector<LiveInterval> intervals;
+      std::unordered_map<std::string, int64_t> interval_by_name;
+      for (int64_t id = 0; id < width; id++) {
+        Variable *var = liveness.variables[id];
+        if (dynamic_cast<Register*>(var)) {
+          auto position = std::find(gp_registers.begin(), gp_registers.end(), var->print());
+          if (position != gp_registers.end()) register_of[id] = position - gp_registers.begin();
+          continue;
+        }
+        auto inserted = interval_by_name.insert({var->name, intervals.size()});
+        if (inserted.second) {
+          bool spill_temporary = fptr->spill_variables_set.count(var)
+              || (var->name.size() > 1 && var->name[0] == '%' && var->name[1] == 'S');
+          intervals.push_back({var->name, n, -1, {}, spill_temporary, false, -1});
+        }
+        interval_of[id] = inserted.first->second;
+        intervals[interval_of[id]].vars.push_back(var);
+      }
+
+      auto touch = [&](int64_t id, int64_t position) {
+        if (interval_of[id] == -1) return;
+        LiveInterval &interval = intervals[interval_of[id]];
+        if (position < interval.start) interval.start = position;
+        if (position > interval.end) interval.end = position;
+      };
+
+      /*
+      Variable intervals: live across a block boundary extends to the boundary, every use/def extends to that position.
+      Register ranges: walk each block backwards keeping the live registers as a mask, a register is busy at every
+      position where it is live in, live out, used or defined.
+      */
+      std::vector<uint32_t> busy(n, 0);
+      for (size_t b = 0; b < liveness.block_first.size(); b++) {
+        int64_t first = liveness.block_first[b];
+        int64_t last = liveness.block_last[b];
+        uint32_t live = 0;
+        liveness.block_in[b].for_each([&](size_t id) { touch(id, first); });
+        liveness.block_out[b].for_each([&](size_t id) {
+          touch(id, last);
+          if (register_of[id] != -1) live |= 1u << register_of[id];
+        });
+        for (int64_t i = last; i >= first; i--) {
+          uint32_t gen_mask = 0;
+          uint32_t kill_mask = 0;
+          liveness.gen[i].for_each([&](size_t id) {
+            touch(id, i);
+            if (register_of[id] != -1) gen_mask |= 1u << register_of[id];
+          });
+          liveness.kill[i].for_each([&](size_t id) {
+            touch(id, i);
+            if (register_of[id] != -1) kill_mask |= 1u << register_of[id];
+          });
+          busy[i] = live | kill_mask;
+          live = gen_mask | (live & ~kill_mask);
+          busy[i] |= live;
+        }
+      }
+
+      /*
+      Prefix counts of the busy positions, so "is this register free over [start, end]" is O(1).
+      */
+      std::vector<std::vector<int32_t>> busy_prefix(colors, std::vector<int32_t>(n + 1, 0));
+      for (int64_t r = 0; r < colors; r++) {
+        for (int64_t i = 0; i < n; i++) {
+          busy_prefix[r][i + 1] = busy_prefix[r][i] + ((busy[i] >> r) & 1);
+        }
+      }
+      auto register_free = [&](int64_t r, const LiveInterval &interval) {
+        return busy_prefix[r][interval.end + 1] - busy_prefix[r][interval.start] == 0;
+      };
+
+      /*
+      Same constraint build_graph adds: a variable shift amount can only be rcx.
+      */
+      for (auto iptr : fptr->instructions) {
+        if (iptr->kind != InstructionKind::sop) continue;
+        auto source = as_variable(static_cast<SOP_assignment*>(iptr)->src);
+        if (!source || source->kind == ItemKind::reg) continue;
+        auto it = interval_by_name.find(source->name);
+        if (it != interval_by_name.end()) intervals[it->second].shift_source = true;
+      }
+      int64_t rcx = std::find(gp_registers.begin(), gp_registers.end(), "rcx") - gp_registers.begin();
+
+      std::vector<int64_t> order;
+      for (size_t i = 0; i < intervals.size(); i++) {
+        if (intervals[i].end >= 0) order.push_back(i);
+      }
+      std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+        if (intervals[a].start != intervals[b].start) return intervals[a].start < intervals[b].start;
+        return intervals[a].name < intervals[b].name;
+      });
+
+      /*
+      The scan. active holds (end, interval) of the intervals currently sitting in a register.
+      */
+      std::set<std::pair<int64_t, int64_t>> active;
+      std::vector<int64_t> owner(colors, -1);
+      std::vector<Variable*> spills;
+      for (auto current : order) {
+        LiveInterval &interval = intervals[current];
+
+        while (!active.empty() && active.begin()->first < interval.start) {
+          owner[intervals[active.begin()->second].reg] = -1;
+          active.erase(active.begin());
+        }
+
+        for (int64_t r = 0; r < colors; r++) {
+          if (interval.shift_source && r != rcx) continue;
+          if (owner[r] == -1 && register_free(r, interval)) {
+            interval.reg = r;
+            break;
+          }
+        }
+
+        if (interval.reg == -1) {
+          /*
+          No free register: look for the active interval ending last whose register would fit this interval.
+          */
+          int64_t victim = -1;
+          for (auto it = active.rbegin(); it != active.rend(); it++) {
+            LiveInterval &candidate = intervals[it->second];
+            if (candidate.spill_temporary) continue;
+            if (interval.shift_source && candidate.reg != rcx) continue;
+            if (!register_free(candidate.reg, interval)) continue;
+            victim = it->second;
+            break;
+          }
+
+          if (victim != -1 && (intervals[victim].end > interval.end || interval.spill_temporary)) {
+            LiveInterval &spilled = intervals[victim];
+            active.erase({spilled.end, victim});
+            interval.reg = spilled.reg;
+            spilled.reg = -1;
+            spills.push_back(spilled.vars.front());
+          } else if (!interval.spill_temporary) {
+            spills.push_back(interval.vars.front());
+            continue;
+          } else {
+            if (debug) std::cerr << "linear scan: no register for spill temporary " << interval.name << std::endl;
+            return std::make_tuple(true, spills);
+          }
+        }
+
+        owner[interval.reg] = current;
+        active.insert({interval.end, current});
+      }
+
+      if (!spills.empty()) {
+        if (debug) std::cerr << "linear scan: spilling " << spills.size() << " variables" << std::endl;
+        return std::make_tuple(false, spills);
+      }
+
+      /*
+      Everything got a register: rename the variables in place (the instructions share these objects).
+      */
+      for (auto &interval : intervals) {
+        if (interval.reg == -1) continue;
+        Variable *reg = fptr->variable_allocator.allocate_variable(gp_registers[interval.reg], VariableType::reg);
+        for (auto var : interval.vars) {
+          *var = *reg;
+        }
+      }
+      return std::make_tuple(false, spills);
+    }
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "L2.h"
+
+namespace L2 {
+
+    /*
+    Live interval of one variable over the linearized instruction order (instruction positions of the function).
+    - the interval is the hull of every position where the variable is live in, live out, used or defined,
+      so two variables whose intervals don't overlap can never interfere.
+    - every Variable object with the same name shares one interval (the spiller can leave copies around).
+    */
+    struct LiveInterval {
+      std::string name;
+      int64_t start;
+      int64_t end;
+      std::vector<Variable*> vars;
+      bool spill_temporary;   // a %S temporary made by spill_variables, never spilled again
+      bool shift_source;      // used as the shift amount of a sop, so it can only live in rcx
+      int64_t reg;            // index into gp_registers, -1 if not assigned
+    };
+
+    /*
+    Linear scan register allocation (Poletto & Sarkar), the -O0/-O1 allocator.
+    - intervals come from one liveness pass; physical registers are handled as fixed ranges (every position where the
+      register is live, used or defined), so calls, arguments, rcx shifts and callee saved registers are respected.
+    - when no register is free the active interval ending furthest away is spilled (or the current one if it ends later).
+    Returns (failed, variables to spill). On success with nothing to spill every variable has been renamed to its register.
+    failed is set when a spill temporary can't get a register, the caller then has to fall back to graph coloring.
+    */
+    std::tuple<bool, std::vector<Variable*>> linear_scan(Function *fptr);
+
+}
@@ -17,7 +17,7 @@ namespace L2{
     Utility vectors for calling convention checks
     */
 
-    std::vector<std::string> arguments_vec{
+    const std::vector<std::string> arguments_vec{
             "rdi",
             "rsi",
             "rdx",
@@ -25,7 +25,7 @@ namespace L2{
             "r8",
             "r9"
     };
-    std::vector<std::string> caller_save_vec{
+    const std::vector<std::string> caller_save_vec{
             "r10",
             "r11",
             "r8",
@@ -36,7 +36,7 @@ namespace L2{
             "rdx",
             "rsi"
     };
-    std::vector<std::string> callee_save_vec{
+    const std::vector<std::string> callee_save_vec{
             "r12",
             "r13",
             "r14",
@@ -45,61 +45,6 @@ namespace L2{
             "rbx"
     };
 
-    /*
-    In and Out Set Storage
-    */
-    In_Out_Store::In_Out_Store(Program *p) {
-        for (auto functionptr : p->functions) {
-            std::unordered_map<Instruction*, std::set<Variable*>> in_set_map;
-            std::unordered_map<Instruction*, std::set<Variable*>> out_set_map;
-            for (auto instructionptr : functionptr->instructions) {
-                in_set_map[instructionptr] = std::set<Variable*>();
-                out_set_map[instructionptr] = std::set<Variable*>();
-            }
-            In_Set.push_back(in_set_map);
-            Out_Set.push_back(out_set_map);
-        }
-    }
-    void In_Out_Store::print_sets(int function_index, Instruction* instruction_ptr) {
-        std::cerr << "In Set: ";
-        for (auto variable_ptr : In_Set[function_index][instruction_ptr]) {
-            std::cerr << variable_ptr->print() << ", ";
-        }
-        std::cerr << std::endl << "Out Set: ";
-        for (auto variable_ptr : Out_Set[function_index][instruction_ptr]) {
-            std::cerr << variable_ptr->print() << ", ";
-        }
-        std::cerr << std::endl;
-    }
-
-    /*
-    Gen and Kill Set Storage
-    */
-    Gen_Kill_Store::Gen_Kill_Store(Program *p) {
-        for (auto functionptr : p->functions) {
-            std::unordered_map<Instruction*, std::set<Variable*>> gen_set_map;
-            std::unordered_map<Instruction*, std::set<Variable*>> kill_set_map;
-            for (auto instructionptr : functionptr->instructions) {
-                gen_set_map[instructionptr] = std::set<Variable*>();
-                kill_set_map[instructionptr] = std::set<Variable*>();
-            }
-            Gen_Set.push_back(gen_set_map);
-            Kill_Set.push_back(kill_set_map);
-        }
-    }
-    void Gen_Kill_Store::print_sets(int function_index, Instruction* instruction_ptr) {
-        std::cerr << "Gen Set: ";
-        for (auto variable_ptr : Gen_Set[function_index][instruction_ptr]) {
-            std::cerr << variable_ptr->print() << ", ";
-        }
-        std::cerr << std::endl << "Kill Set: ";
-        for (auto variable_ptr : Kill_Set[function_index][instruction_ptr]) {
-            std::cerr << variable_ptr->print() << ", ";
-        }
-        std::cerr << std::endl;
-    }
-    
-
     /*
     Full Liveness Analysis
     */
@@ -107,15 +52,16 @@ namespace L2{
     // Curr_F_Liveness liveness_analysis(Program *p, int function_index, Gen_Kill_Store gen_kill_sets, In_Out_Store in_out_sets, bool print) {
     // Curr_F_Liveness liveness_analysis(Function* fptr, bool print) {
     Curr_F_Liveness liveness_analysis(Function* fptr) {
+        PhaseScope timer(Phase::liveness, &fptr->stats.liveness_ms);
         if (debug) std::cerr << "Running Liveness Analysis..." << std::endl;
 
         /*
-        Initialize sets to hold each instruction's gen, kill, in, and out.
+        Initialize sets to hold each instruction's gen and kill before the variables are numbered.
+        - these are indexed by instruction position, same as the bit vectors in the result.
         */
-        std::unordered_map<Instruction*, std::set<Variable*>> gen_sets;
-        std::unordered_map<Instruction*, std::set<Variable*>> kill_sets;
-        std::unordered_map<Instruction*, std::set<Variable*>> in_sets;
-        std::unordered_map<Instruction*, std::set<Variable*>> out_sets;
+        int64_t instruction_count = fptr->instructions.size();
+        std::vector<std::set<Variable*>> gen_sets(instruction_count);
+        std::vector<std::set<Variable*>> kill_sets(instruction_count);
 
         /*
         Run the liveness analysis algorithm for the current function
@@ -131,147 +77,126 @@ namespace L2{
         /*
         Calcuate Gen and Kill sets for each instruction in the current function using the Uses/Defs sets and calling convention rules
         */
-        for (auto instruction_ptr : fptr->instructions) {
+        for (int64_t instruction_index = 0; instruction_index < instruction_count; instruction_index++) {
+            Instruction* instruction_ptr = fptr->instructions[instruction_index];
             if (debug) std::cerr << "ENTERED" << std::endl;
             /*
             Define pointer references to the current instruction's Gen/Kill sets for convenience
             */
-            // std::set<Variable*>* gen_set_ptr = &gen_kill_sets.Gen_Set[function_index][instruction_ptr];
-            // std::set<Variable*>* kill_set_ptr = &gen_kill_sets.Kill_Set[function_index][instruction_ptr];
-            std::set<Variable*>* gen_set_ptr = &gen_sets[instruction_ptr];
-            std::set<Variable*>* kill_set_ptr = &kill_sets[instruction_ptr];
+            std::set<Variable*>* gen_set_ptr = &gen_sets[instruction_index];
+            std::set<Variable*>* kill_set_ptr = &kill_sets[instruction_index];
 
             /*
             Place Uses into Gen
             */
-            for (auto variable_ptr : instruction_ptr->used) {
+            for (auto variable_ptr : fptr->tables.uses(instruction_index)) {
                 gen_set_ptr->insert(variable_ptr);
             }
             /*
             Place Defs into Kill
             */
-            for (auto variable_ptr : instruction_ptr->defined) {
+            for (auto variable_ptr : fptr->tables.defs(instruction_index)) {
                 kill_set_ptr->insert(variable_ptr);
             }
             /*
-            Dynamic cast to check for special calling convention cases
+            Special calling convention cases, picked by the instruction's kind tag
             */
-            Call_uN_Instruction* call_uN_instruction_ptr = dynamic_cast<Call_uN_Instruction*>(instruction_ptr);
-            if (call_uN_instruction_ptr) {
-                /*
-                --- call u N ---
-                Gen <- {u, args used}
-                Kill <- {caller-saved}
-                */
-                // Gen, finding 'u' 
-                Variable* variable_ptr = dynamic_cast<Variable*>(call_uN_instruction_ptr->u);
-                if (variable_ptr) {
-                    Register* register_ptr = dynamic_cast<Register*>(variable_ptr);
-                    if (register_ptr) {
-                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_ptr->name, VariableType::reg));
-                    } else {
-                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(variable_ptr->name, VariableType::var));
+            switch (instruction_ptr->kind) {
+                case InstructionKind::call_uN: {
+                    /*
+                    --- call u N ---
+                    Gen <- {u, args used}
+                    Kill <- {caller-saved}
+                    */
+                    auto call_uN_instruction_ptr = static_cast<Call_uN_Instruction*>(instruction_ptr);
+                    // Gen, finding 'u' 
+                    if (call_uN_instruction_ptr->u->kind == ItemKind::reg) {
+                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(static_cast<Register*>(call_uN_instruction_ptr->u)->name, VariableType::reg));
+                    } else if (call_uN_instruction_ptr->u->kind == ItemKind::variable) {
+                        /*
+                        Use the variable object of the instruction itself: a spill temporary is not necessarily the
+                        allocator's object, and a second object with the same name would look live from the entry on.
+                        */
+                        gen_set_ptr->insert(static_cast<Variable*>(call_uN_instruction_ptr->u));
                     }
-                }
-                // Gen, finding 'args used'
-                Number* num = dynamic_cast<Number*>(call_uN_instruction_ptr->N);
-                for (int i = 0; i < num->value; i++) {
-                    if (i>5){
-                        break;
+                    // Gen, finding 'args used'
+                    Number* num = static_cast<Number*>(call_uN_instruction_ptr->N);
+                    for (int i = 0; i < num->value; i++) {
+                        if (i>5){
+                            break;
+                        }
+                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
                     }
-                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
-                }
-                // Kill, finding 'caller-saved'
-                for (auto register_string : caller_save_vec) {
-                    kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
-                }
-            }
-            /*
-            --- call RUNTIME N ---
-            Gen <- {args used}
-            Kill <- {caller-saved}
-            */
-            Call_print_Instruction* call_print_instruction_ptr = dynamic_cast<Call_print_Instruction*>(instruction_ptr);
-            if (call_print_instruction_ptr) {
-                /*
-                call print 1
-                */
-                // Gen, finding 'args used'
-                gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[0], VariableType::reg));
-                // Kill, finding 'caller-saved'
-                for (auto register_string : caller_save_vec) {
-                    kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
+                    break;
                 }
-            }
-            Call_input_Instruction* call_input_instruction_ptr = dynamic_cast<Call_input_Instruction*>(instruction_ptr);
-            if (call_input_instruction_ptr) {
                 /*
-                call input 1
-                */
-                // Kill, finding 'caller-saved'
-                for (auto register_string : caller_save_vec) {
-                    kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
-                }
-            }
-            Call_allocate_Instruction* call_allocate_instruction_ptr = dynamic_cast<Call_allocate_Instruction*>(instruction_ptr);
-            if (call_allocate_instruction_ptr) {
-                /*
-                call allocate 2
-                */
-                // Gen, finding 'args used'
-                for (int i = 0; i < 2; i++) {
-                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
-                }
-                // Kill, finding 'caller-saved'
-                for (auto register_string : caller_save_vec) {
-                    kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
-                }
-            }
-            Call_tuple_Instruction* call_tuple_instruction_ptr = dynamic_cast<Call_tuple_Instruction*>(instruction_ptr);
-            if (call_tuple_instruction_ptr) {
-                /*
-                call tuple-error 3
-                */
-                // Gen, finding 'args used'
-                for (int i = 0; i < 3; i++) {
-                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
-                }
-                // Kill, finding 'caller-saved'
-                for (auto register_string : caller_save_vec) {
-                    kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
-                }
-            }
-            Call_tenserr_Instruction* call_tenserr_instruction_ptr = dynamic_cast<Call_tenserr_Instruction*>(instruction_ptr);
-            if (call_tenserr_instruction_ptr) {
-                /*
-                call tensor-error F
+                --- call RUNTIME N ---
+                Gen <- {args used}
+                Kill <- {caller-saved}
                 */
-                // Gen, finding 'args used'
-                Number* number_ptr = dynamic_cast<Number*>(call_tenserr_instruction_ptr->F);
-                if (number_ptr) {
-                    for (int i = 0; i < number_ptr->value; i++) {
+                case InstructionKind::call_print:
+                    /*
+                    call print 1
+                    */
+                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[0], VariableType::reg));
+                    break;
+                case InstructionKind::call_input:
+                    /*
+                    call input 0
+                    */
+                    break;
+                case InstructionKind::call_allocate:
+                    /*
+                    call allocate 2
+                    */
+                    for (int i = 0; i < 2; i++) {
+                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
+                    }
+                    break;
+                case InstructionKind::call_tuple:
+                    /*
+                    call tuple-error 3
+                    */
+                    for (int i = 0; i < 3; i++) {
                         gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
                     }
+                    break;
+                case InstructionKind::call_tenserr: {
+                    /*
+                    call tensor-error F
+                    */
+                    Item *F = static_cast<Call_tenserr_Instruction*>(instruction_ptr)->F;
+                    if (F->kind == ItemKind::number) {
+                        for (int i = 0; i < static_cast<Number*>(F)->value; i++) {
+                            gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(arguments_vec[i], VariableType::reg));
+                        }
+                    }
+                    break;
                 }
-                // Kill, finding 'caller-saved'
+                case InstructionKind::ret:
+                    /*
+                    --- return ---
+                    Gen <- {rax, callee-saved}
+                    Kill <- {}
+                    - with shrink wrapping the callee-saved registers are saved after allocation instead
+                    */
+                    // Gen, finding 'rax'
+                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable("rax", VariableType::reg));
+                    // Gen, finding 'callee-saved'
+                    if (fptr->shrink_wrap) break;
+                    for (auto register_string : callee_save_vec) {
+                        gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
+                    }
+                    break;
+                default:
+                    break;
+            }
+            // Kill, finding 'caller-saved'
+            if (is_call(instruction_ptr)) {
                 for (auto register_string : caller_save_vec) {
                     kill_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
                 }
             }
-            Instruction_ret* return_instruction_ptr = dynamic_cast<Instruction_ret*>(instruction_ptr);
-            if (return_instruction_ptr) {
-                /*
-                --- return ---
-                Gen <- {rax, callee-saved}
-                Kill <- {}
-                */
-                // Gen, finding 'rax'
-                gen_set_ptr->insert(fptr->variable_allocator.allocate_variable("rax", VariableType::reg));
-                // Gen, finding 'callee-saved'
-                for (auto register_string : callee_save_vec) {
-                    gen_set_ptr->insert(fptr->variable_allocator.allocate_variable(register_string, VariableType::reg));
-                }
-            }
 
             /*
             Verify Gen and Kill sets by printing
@@ -281,134 +206,150 @@ namespace L2{
         }   // finished with Gen and Kill
         
         /*
-        Calcuate Predeccesors and Successors sets for each instruction in the current function with our algorithm
+        Number every variable and register that shows up in a gen or kill set with a dense id.
+        - ids are handed out in name order, so walking a bit vector (and so the -l output) is
+          deterministic instead of depending on where the allocator placed each Variable.
         */
-        if (debug) std::cerr << "pre CFG brrrr" << std::endl;
-        fptr->calculateCFG();
-        if (debug) std::cerr << "CFG brrrr" << std::endl;
-
-        int instruction_number;  
-        bool changed;
-        instruction_number = 0;
-        bool tensor_error_encountered = false;
-        std::set<Instruction*> sealed_instructions;
-        do {
-            changed = false;
-            for (auto instruction_ptr : fptr->instructions) {
-                instruction_number++;
-
-                /*
-                    Define pointers to the Gen, Kill, In, Out sets for the current instruction
-                */
-                // std::set<Variable*>* gen_set_ptr = &gen_kill_sets.Gen_Set[function_index][instruction_ptr];
-                // std::set<Variable*>* kill_set_ptr = &gen_kill_sets.Kill_Set[function_index][instruction_ptr];
-                // std::set<Variable*>* in_set_ptr = &in_out_sets.In_Set[function_index][instruction_ptr];
-                // std::set<Variable*>* out_set_ptr = &in_out_sets.Out_Set[function_index][instruction_ptr];
-                std::set<Variable*>* gen_set_ptr = &gen_sets[instruction_ptr];
-                std::set<Variable*>* kill_set_ptr = &kill_sets[instruction_ptr];
-                std::set<Variable*>* in_set_ptr = &in_sets[instruction_ptr];
-                std::set<Variable*>* out_set_ptr = &out_sets[instruction_ptr];
+        Curr_F_Liveness result;
+        for (int64_t i = 0; i < instruction_count; i++) {
+            result.variables.insert(result.variables.end(), gen_sets[i].begin(), gen_sets[i].end());
+            result.variables.insert(result.variables.end(), kill_sets[i].begin(), kill_sets[i].end());
+        }
+        std::sort(result.variables.begin(), result.variables.end());
+        result.variables.erase(std::unique(result.variables.begin(), result.variables.end()), result.variables.end());
+        std::stable_sort(result.variables.begin(), result.variables.end(), [](Variable* a, Variable* b) {
+            return a->name < b->name;
+        });
+        for (int64_t id = 0; id < (int64_t)result.variables.size(); id++) {
+            result.variable_ids[result.variables[id]] = id;
+        }
 
+        /*
+        Move the Gen and Kill sets over to bit vectors.
+        */
+        size_t width = result.variables.size();
+        result.gen.assign(instruction_count, BitVector(width));
+        result.kill.assign(instruction_count, BitVector(width));
+        for (int64_t i = 0; i < instruction_count; i++) {
+            for (auto variable_ptr : gen_sets[i]) result.gen[i].set(result.variable_ids[variable_ptr]);
+            for (auto variable_ptr : kill_sets[i]) result.kill[i].set(result.variable_ids[variable_ptr]);
+        }
 
-                // if (debug) std::cerr << "computing In and Out sets for the current instruction..." << std::endl;
+        /*
+        Solve over the basic blocks of the function's CFG.
+        */
+        const ControlFlowGraph &cfg = fptr->control_flow();
+        result.block_first = cfg.block_first;
+        result.block_last = cfg.block_last;
+        result.block_of = cfg.block_of;
+        int64_t block_count = cfg.block_count();
 
-                /*
-                    Define state of the In set before any potential changes are made
-                */
-                std::set<Variable*> in_set_prev = *in_set_ptr;
+        /*
+        Summarize each block by its upward exposed uses and its definitions, walking the block bottom up:
+        Use_B = Gen[i] U (Use_B - Kill[i]), Def_B = Def_B U Kill[i].
+        */
+        std::vector<BitVector> block_use(block_count, BitVector(width));
+        std::vector<BitVector> block_def(block_count, BitVector(width));
+        for (int64_t b = 0; b < block_count; b++) {
+            for (int64_t i = result.block_last[b]; i >= result.block_first[b]; i--) {
+                block_use[b].assign_transfer(result.gen[i], block_use[b], result.kill[i]);
+                block_def[b].union_with(result.kill[i]);
+            }
+        }
 
-                /*
-                    Do the In set operations
-                */
-                std::set<Variable*> In_Result;
-                std::set<Variable*> Out_Kill_Diff;
-                std::set_difference(
-                    out_set_ptr->begin(), out_set_ptr->end(),
-                    kill_set_ptr->begin(), kill_set_ptr->end(),
-                    std::inserter(Out_Kill_Diff, Out_Kill_Diff.begin())
-                );
-                std::set_union(
-                    gen_set_ptr->begin(), gen_set_ptr->end(),
-                    Out_Kill_Diff.begin(), Out_Kill_Diff.end(),
-                    std::inserter(In_Result, In_Result.begin())
-                );
+        /*
+        Order the blocks so that each one comes after its successors (postorder, the reverse of the CFG's RPO,
+        which is the order a backward problem wants). Blocks unreachable from the entry go last.
+        */
+        std::vector<int64_t> block_order(cfg.rpo.rbegin(), cfg.rpo.rend());
+        for (int64_t b = 0; b < block_count; b++) {
+            if (cfg.rpo_index[b] == -1) block_order.push_back(b);
+        }
+        std::vector<int64_t> order_position(block_count);
+        for (int64_t p = 0; p < block_count; p++) {
+            order_position[block_order[p]] = p;
+        }
 
-                /*
-                    Define state of the Out set before any potential changes are made
-                */
-                std::set<Variable*> out_set_prev = *out_set_ptr;
+        /*
+        Worklist over blocks, always taking the pending block earliest in the order above:
+        Out_B = U In_S over successors S, In_B = Use_B U (Out_B - Def_B).
+        When In_B grows, its predecessors go back on the worklist.
+        */
+        result.block_in.assign(block_count, BitVector(width));
+        result.block_out.assign(block_count, BitVector(width));
+        std::set<int64_t> worklist;
+        for (int64_t p = 0; p < block_count; p++) {
+            worklist.insert(p);
+        }
+        while (!worklist.empty()) {
+            int64_t b = block_order[*worklist.begin()];
+            worklist.erase(worklist.begin());
 
-                /*
-                    Do the In set operations
-                */
-                //
-                std::set<Variable*> Out_Result;
-                for (auto successor : instruction_ptr->successors) {
-                    // note that successor should be of type Instruction*
-                    // std::set<Variable*> successor_in_set = in_out_sets.In_Set[function_index][successor];
-                    std::set<Variable*> successor_in_set = in_sets[successor];
-                    std::set<Variable*> temp_union_set;
-                    std::set_union(
-                        Out_Result.begin(), Out_Result.end(),
-                        successor_in_set.begin(), successor_in_set.end(),
-                        std::inserter(temp_union_set, temp_union_set.begin())
-                    );
-                    Out_Result = std::move(temp_union_set);
+            for (auto successor : cfg.successors[b]) {
+                result.block_out[b].union_with(result.block_in[successor]);
+            }
+            if (result.block_in[b].assign_transfer(block_use[b], result.block_out[b], block_def[b])) {
+                for (auto predecessor : cfg.predecessors[b]) {
+                    worklist.insert(order_position[predecessor]);
                 }
-
-                *in_set_ptr = In_Result;
-                *out_set_ptr = Out_Result;
-                changed = changed || ((in_set_prev != *in_set_ptr) || (out_set_prev != *out_set_ptr));
             }
-        } while (changed);
+        }
 
-        /*
-        Return the sets as a pair
-        */
-        // LivenessResult result = {gen_kill_sets, in_out_sets};
+        result.instruction_in.resize(instruction_count);
+        result.instruction_out.resize(instruction_count);
+        result.block_expanded.assign(block_count, false);
 
-        Curr_F_Liveness result = {
-            // gen_kill_sets.Gen_Set[function_index],
-            // gen_kill_sets.Kill_Set[function_index],
-            // in_out_sets.In_Set[function_index],
-            // in_out_sets.Out_Set[function_index]
-            gen_sets, kill_sets, in_sets, out_sets
-        };
         return result;
     }
 
+    /*
+    Per-instruction In/Out sets, expanded from the block's Out set the first time any instruction
+    of that block is asked for.
+    */
+    const BitVector& Curr_F_Liveness::in(int64_t instruction_index) {
+        expand_block(block_of[instruction_index]);
+        return instruction_in[instruction_index];
+    }
+
+    const BitVector& Curr_F_Liveness::out(int64_t instruction_index) {
+        expand_block(block_of[instruction_index]);
+        return instruction_out[instruction_index];
+    }
+
+    void Curr_F_Liveness::expand_block(int64_t block) {
+        if (block_expanded[block]) return;
+        block_expanded[block] = true;
+        BitVector live = block_out[block];
+        for (int64_t i = block_last[block]; i >= block_first[block]; i--) {
+            instruction_out[i] = live;
+            live.assign_transfer(gen[i], live, kill[i]);
+            instruction_in[i] = live;
+        }
+    }
+
     /*
     Print the liveness set for the current function to std::cout
     */
-    void print_liveness(Function* fptr, Curr_F_Liveness liveness_results) {
+    void print_liveness(Function* fptr, Curr_F_Liveness& liveness_results) {
         std::cout << "(\n";
         std::cout << "(in\n";
-        // for (const auto& pair : liveness_results.in) {
-        for (const auto& iptr : fptr->instructions) {
+        for (size_t i = 0; i < fptr->instructions.size(); i++) {
             std::cout << "(";
-            // for (const auto& variable_ptr : pair.second) {
-            for (const auto& variable_ptr : liveness_results.in[iptr]) {
-                std::cout << variable_ptr->print() << " ";
-            }
+            liveness_results.in(i).for_each([&](size_t id) {
+                std::cout << liveness_results.variables[id]->print() << " ";
+            });
             std::cout << ")\n";
         }
         std::cout << ")\n\n";
         std::cout << "(out\n";
-        // for (const auto& pair : liveness_results.out) {
-        for (const auto& iptr : fptr->instructions) {
+        for (size_t i = 0; i < fptr->instructions.size(); i++) {
             std::cout << "(";
-            for (const auto& variable_ptr : liveness_results.out[iptr]) {
-                std::cout << variable_ptr->print() << " ";
-            }
+            liveness_results.out(i).for_each([&](size_t id) {
+                std::cout << liveness_results.variables[id]->print() << " ";
+            });
             std::cout << ")\n";
         }
         std::cout << ")\n\n";
         std::cout << ")\n\n";
     }
-
-
-
-
-    
-
 }
\ No newline at end of file
@@ -12,6 +12,6 @@ namespace L2{
   /*
   
   */
-  void print_liveness(Function* fptr, Curr_F_Liveness liveness_results);
+  void print_liveness(Function* fptr, Curr_F_Liveness& liveness_results);
 
 }
@@ -0,0 +1,117 @@
+#include "lower_to_L1.h"
+
+namespace L2 {
+
+    /*
+    Builds the L1 instruction of every L2 instruction it visits; after allocation all variables are registers.
+    */
+    class LowerVisitor : public Visitor {
+      public:
+        LowerVisitor(Function *fptr) : fptr(fptr) {}
+
+        L1::Item* item(Item *item) {
+          switch (item->kind) {
+            case ItemKind::variable:
+            case ItemKind::reg:
+              return new L1::Register(item->print());
+            case ItemKind::number:
+              return new L1::Number(as_number(item)->value);
+            case ItemKind::name:
+              return new L1::Name(item->print());
+            case ItemKind::label:
+              return new L1::Label(item->print());
+            case ItemKind::op:
+              return new L1::Operator(item->print());
+          }
+          return nullptr;
+        }
+
+        void visit(Instruction_ret *instruction) override {
+          lowered = new L1::Instruction_ret();
+        }
+        void visit(Instruction_assignment *instruction) override {
+          lowered = new L1::Instruction_assignment(item(instruction->d), item(instruction->s));
+        }
+        void visit(label_Instruction *instruction) override {
+          lowered = new L1::label_Instruction(item(instruction->label));
+        }
+        void visit(goto_label_instruction *instruction) override {
+          lowered = new L1::goto_label_instruction(item(instruction->label));
+        }
+        void visit(Call_tenserr_Instruction *instruction) override {
+          lowered = new L1::Call_tenserr_Instruction(item(instruction->F));
+        }
+        void visit(Call_uN_Instruction *instruction) override {
+          lowered = new L1::Call_uN_Instruction(item(instruction->u), item(instruction->N));
+        }
+        void visit(Call_print_Instruction *instruction) override {
+          lowered = new L1::Call_print_Instruction();
+        }
+        void visit(Call_input_Instruction *instruction) override {
+          lowered = new L1::Call_input_Instruction();
+        }
+        void visit(Call_allocate_Instruction *instruction) override {
+          lowered = new L1::Call_allocate_Instruction();
+        }
+        void visit(Call_tuple_Instruction *instruction) override {
+          lowered = new L1::Call_tuple_Instruction();
+        }
+        void visit(w_increment_decrement *instruction) override {
+          lowered = new L1::w_increment_decrement(item(instruction->r), item(instruction->symbol));
+        }
+        void visit(w_atreg_assignment *instruction) override {
+          lowered = new L1::w_atreg_assignment(item(instruction->r1), item(instruction->r2), item(instruction->r3), item(instruction->E));
+        }
+        void visit(Memory_assignment_store *instruction) override {
+          lowered = new L1::Memory_assignment_store(item(instruction->dst), item(instruction->s), item(instruction->M));
+        }
+        void visit(Memory_assignment_load *instruction) override {
+          lowered = new L1::Memory_assignment_load(item(instruction->dst), item(instruction->x), item(instruction->M));
+        }
+        void visit(Memory_arithmetic_load *instruction) override {
+          lowered = new L1::Memory_arithmetic_load(item(instruction->dst), item(instruction->x), item(instruction->instruction), item(instruction->M));
+        }
+        void visit(Memory_arithmetic_store *instruction) override {
+          lowered = new L1::Memory_arithmetic_store(item(instruction->dst), item(instruction->t), item(instruction->instruction), item(instruction->M));
+        }
+        void visit(cmp_Instruction *instruction) override {
+          lowered = new L1::cmp_Instruction(item(instruction->dst), item(instruction->t2), item(instruction->method), item(instruction->t1));
+        }
+        void visit(cjump_cmp_Instruction *instruction) override {
+          lowered = new L1::cjump_cmp_Instruction(item(instruction->t2), item(instruction->cmp), item(instruction->t1), item(instruction->label));
+        }
+        void visit(stackarg_assignment *instruction) override {
+          /*
+          Stack arguments sit right above the frame, as in generate_function_code.
+          */
+          lowered = new L1::Memory_assignment_load(item(instruction->w), new L1::Register("rsp"),
+                                                   new L1::Number(as_number(instruction->M)->value + 8 * fptr->locals));
+        }
+        void visit(AOP_assignment *instruction) override {
+          lowered = new L1::AOP_assignment(item(instruction->method), item(instruction->dst), item(instruction->src));
+        }
+        void visit(SOP_assignment *instruction) override {
+          lowered = new L1::SOP_assignment(item(instruction->method), item(instruction->dst), item(instruction->src));
+        }
+
+        L1::Instruction *lowered = nullptr;
+
+      private:
+        Function *fptr;
+    };
+
+    L1::Function* lower_function(Function *fptr) {
+      PhaseScope timer(Phase::code_generation);
+      auto lowered_function = new L1::Function();
+      lowered_function->name = fptr->name;
+      lowered_function->arguments = fptr->arguments;
+      lowered_function->locals = fptr->locals;
+      LowerVisitor visitor(fptr);
+      for (Instruction *iptr : fptr->instructions) {
+        iptr->accept(&visitor);
+        lowered_function->instructions.push_back(visitor.lowered);
+      }
+      return lowered_function;
+    }
+
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <L1.h>
+
+#include "L2.h"
+
+namespace L2 {
+
+    /*
+    The allocated function as an L1 function, built out of the L1 library's classes instead of printed as L1 text.
+    - it is the function generate_function_code prints, item for item: bin/L1 parsing that text would build the
+      same objects, so the assembly the library writes is the one the L1 compiler would have written.
+    - the L1 objects own copies of every string, they outlive the arena of the L2 function.
+    */
+    L1::Function* lower_function(Function *fptr);
+
+}
@@ -0,0 +1,353 @@
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "pbqp_allocation.h"
+#include "graph_coloring.h"
+#include "register_coalescing.h"
+#include "spill_cost.h"
+
+using namespace std;
+
+namespace L2 {
+
+    static const double infinite_cost = std::numeric_limits<double>::infinity();
+
+    std::tuple<bool, std::vector<Node*>> color_graph_pbqp(Graph *graph, Graph *graph_copy, Function *fptr) {
+      color_registers(graph_copy);
+
+      std::vector<int64_t> register_option(graph_copy->node_list.size(), -1);
+      for (auto node : graph_copy->node_list) {
+        if (!as_register(node->var)) continue;
+        auto position = std::find(gp_registers.begin(), gp_registers.end(), node->color);
+        if (position != gp_registers.end()) register_option[node->id] = position - gp_registers.begin() + 1;
+      }
+      auto is_spill_temporary = [&](Node *node) {
+        auto node_name = node->var->name;
+        return graph_copy->spill_vars.count(node->var) || (node_name.size() > 1 && node_name[0] == '%' && node_name[1] == 'S');
+      };
+
+      /*
+      Node costs: spilling, and the registers each variable interferes with.
+      */
+      std::vector<Node*> variables;
+      std::vector<int64_t> variable_of(graph_copy->node_list.size(), -1);
+      std::vector<std::vector<double>> costs;
+      for (auto node : graph_copy->node_list) {
+        if (as_register(node->var)) continue;
+        std::vector<double> node_costs(PBQPSolver::options, 0);
+        node_costs[0] = is_spill_temporary(node) ? infinite_cost : node->spill_cost;
+        for (auto neighbor : graph_copy->adjacency[node->id]) {
+          if (register_option[neighbor] != -1) node_costs[register_option[neighbor]] = infinite_cost;
+        }
+        variable_of[node->id] = variables.size();
+        variables.push_back(node);
+        costs.push_back(std::move(node_costs));
+      }
+
+      /*
+      Moves: a move to or from a register costs its loop weight in every other option of the variable, a move between
+      two variables is an edge cost (added below, once the nodes exist).
+      */
+      std::vector<int64_t> depths = loop_depths(fptr);
+      std::vector<std::tuple<int64_t, int64_t, double>> variable_moves;
+      for (size_t i = 0; i < fptr->instructions.size(); i++) {
+        Instruction *iptr = fptr->instructions[i];
+        if (iptr->kind != InstructionKind::assignment) continue;
+        auto assignment = static_cast<Instruction_assignment*>(iptr);
+        auto d = as_variable(assignment->d);
+        auto s = as_variable(assignment->s);
+        if (!d || !s) continue;
+        auto d_it = graph_copy->nodes.find(d);
+        auto s_it = graph_copy->nodes.find(s);
+        if (d_it == graph_copy->nodes.end() || s_it == graph_copy->nodes.end()) continue;
+        int64_t x = d_it->second->id;
+        int64_t y = s_it->second->id;
+        double weight = std::pow(10.0, (double)depths[i]);
+        if (variable_of[x] != -1 && variable_of[y] != -1) {
+          if (x != y) variable_moves.push_back({variable_of[x], variable_of[y], weight});
+          continue;
+        }
+        int64_t variable = (variable_of[x] != -1) ? x : y;
+        int64_t reg = (variable == x) ? y : x;
+        if (variable_of[variable] == -1 || register_option[reg] == -1) continue;
+        for (int64_t option = 0; option < PBQPSolver::options; option++) {
+          if (option != register_option[reg]) costs[variable_of[variable]][option] += weight;
+        }
+      }
+
+      PBQPSolver solver;
+      for (size_t v = 0; v < variables.size(); v++) {
+        solver.add_node(costs[v], variables[v]->spill_cost);
+      }
+      for (size_t v = 0; v < variables.size(); v++) {
+        for (auto neighbor : graph_copy->adjacency[variables[v]->id]) {
+          if (variable_of[neighbor] > (int64_t)v) solver.add_interference(v, variable_of[neighbor]);
+        }
+      }
+      std::vector<double> move_costs(PBQPSolver::options * PBQPSolver::options);
+      for (auto& move : variable_moves) {
+        for (int64_t a = 0; a < PBQPSolver::options; a++) {
+          for (int64_t b = 0; b < PBQPSolver::options; b++) {
+            move_costs[a * PBQPSolver::options + b] = (a == b && a > 0) ? 0 : std::get<2>(move);
+          }
+        }
+        solver.add_edge_costs(std::get<0>(move), std::get<1>(move), move_costs);
+      }
+
+      if (!solver.solve(pbqp_work_budget)) {
+        if (debug) std::cerr << fptr->name << ": PBQP ran out of its work budget, coloring instead" << std::endl;
+        return color_graph_coalescing(graph, graph_copy, fptr);
+      }
+
+      /*
+      A solution with an infinite cost term (a spilled spill temporary, or two interfering nodes sharing a register
+      when there was no other way) is no allocation at all.
+      */
+      for (size_t v = 0; v < variables.size(); v++) {
+        int64_t option = solver.selection(v);
+        bool usable = (option != 0 || !is_spill_temporary(variables[v]));
+        for (auto neighbor : graph_copy->adjacency[variables[v]->id]) {
+          if (option == 0 || !usable) break;
+          if (register_option[neighbor] == option) usable = false;
+          if (variable_of[neighbor] != -1 && solver.selection(variable_of[neighbor]) == option) usable = false;
+        }
+        if (!usable) {
+          if (debug) std::cerr << fptr->name << ": PBQP found no finite solution, coloring instead" << std::endl;
+          return color_graph_coalescing(graph, graph_copy, fptr);
+        }
+      }
+
+      std::vector<Node*> uncolored_nodes;
+      for (size_t v = 0; v < variables.size(); v++) {
+        int64_t option = solver.selection(v);
+        if (option == 0) {
+          uncolored_nodes.push_back(variables[v]);
+          continue;
+        }
+        variables[v]->color = gp_registers[option - 1];
+      }
+      if (debug) std::cerr << fptr->name << ": PBQP spills " << uncolored_nodes.size() << " of " << variables.size() << " variables" << std::endl;
+      return std::make_tuple(false, uncolored_nodes);
+    }
+
+    int64_t PBQPSolver::add_node(const std::vector<double> &costs, double node_priority) {
+      int64_t node = node_costs.size();
+      node_costs.push_back(costs);
+      priority.push_back(node_priority);
+      node_edges.push_back({});
+      degree.push_back(0);
+      removed.push_back(false);
+      return node;
+    }
+
+    int64_t PBQPSolver::find_or_add_edge(int64_t u, int64_t v) {
+      uint64_t key = ((uint64_t)std::min(u, v) << 32) | (uint64_t)std::max(u, v);
+      auto it = edge_index.find(key);
+      if (it != edge_index.end()) return it->second;
+      int64_t e = edges.size();
+      Edge edge;
+      edge.u = u;
+      edge.v = v;
+      edges.push_back(std::move(edge));
+      edge_index[key] = e;
+      node_edges[u].push_back(e);
+      node_edges[v].push_back(e);
+      degree[u]++;
+      degree[v]++;
+      return e;
+    }
+
+    void PBQPSolver::add_edge_costs(int64_t u, int64_t v, const std::vector<double> &costs) {
+      Edge &edge = edges[find_or_add_edge(u, v)];
+      if (edge.costs.empty()) edge.costs.assign(options * options, 0);
+      for (int64_t a = 0; a < options; a++) {
+        for (int64_t b = 0; b < options; b++) {
+          edge.costs[(edge.u == u) ? a * options + b : b * options + a] += costs[a * options + b];
+        }
+      }
+    }
+
+    void PBQPSolver::add_interference(int64_t u, int64_t v) {
+      edges[find_or_add_edge(u, v)].interferes = true;
+    }
+
+    double PBQPSolver::edge_cost(const Edge &edge, int64_t from, int64_t from_option, int64_t to_option) const {
+      int64_t a = (edge.u == from) ? from_option : to_option;
+      int64_t b = (edge.u == from) ? to_option : from_option;
+      double cost = edge.costs.empty() ? 0 : edge.costs[a * options + b];
+      if (edge.interferes && a == b && a > 0) cost = infinite_cost;
+      return cost;
+    }
+
+    int64_t PBQPSolver::other_end(const Edge &edge, int64_t node) const {
+      return (edge.u == node) ? edge.v : edge.u;
+    }
+
+    std::vector<int64_t> PBQPSolver::live_edges(int64_t node) {
+      auto& list = node_edges[node];
+      work += list.size();
+      list.erase(std::remove_if(list.begin(), list.end(), [&](int64_t e) { return !edges[e].alive; }), list.end());
+      return list;
+    }
+
+    /*
+    Takes the node out of the graph, remembering the edges it had for choosing its option later.
+    */
+    void PBQPSolver::remove_node(int64_t node) {
+      std::vector<int64_t> node_live_edges = live_edges(node);
+      for (auto e : node_live_edges) {
+        edges[e].alive = false;
+        int64_t neighbor = other_end(edges[e], node);
+        degree[neighbor]--;
+        if (degree[neighbor] <= 2) low_degree.push_back(neighbor);
+        allocatable.push_back(neighbor);
+      }
+      degree[node] = 0;
+      removed[node] = true;
+      reduced.push_back({node, node_live_edges});
+    }
+
+    /*
+    Fewer neighbors than registers the node can still take: whatever they pick, one register is left for it.
+    */
+    bool PBQPSolver::provably_allocatable(int64_t node) const {
+      int64_t usable = 0;
+      for (int64_t option = 1; option < options; option++) {
+        if (node_costs[node][option] != infinite_cost) usable++;
+      }
+      return degree[node] < usable;
+    }
+
+    /*
+    RI: fold the node into its only neighbor, c_y[j] += min_i (c_x[i] + C_xy[i][j]).
+    */
+    void PBQPSolver::reduce_one(int64_t node) {
+      const Edge &edge = edges[live_edges(node)[0]];
+      int64_t neighbor = other_end(edge, node);
+      for (int64_t j = 0; j < options; j++) {
+        double best = infinite_cost;
+        for (int64_t i = 0; i < options; i++) {
+          best = std::min(best, node_costs[node][i] + edge_cost(edge, node, i, j));
+        }
+        node_costs[neighbor][j] += best;
+      }
+      work += options * options;
+      remove_node(node);
+    }
+
+    /*
+    RII: fold the node into an edge between its two neighbors, C_yz[j][k] += min_i (c_x[i] + C_xy[i][j] + C_xz[i][k]).
+    */
+    void PBQPSolver::reduce_two(int64_t node) {
+      std::vector<int64_t> node_live_edges = live_edges(node);
+      int64_t first = node_live_edges[0];
+      int64_t second = node_live_edges[1];
+      int64_t y = other_end(edges[first], node);
+      int64_t z = other_end(edges[second], node);
+      std::vector<double> folded(options * options);
+      for (int64_t j = 0; j < options; j++) {
+        for (int64_t k = 0; k < options; k++) {
+          double best = infinite_cost;
+          for (int64_t i = 0; i < options; i++) {
+            best = std::min(best, node_costs[node][i] + edge_cost(edges[first], node, i, j) + edge_cost(edges[second], node, i, k));
+          }
+          folded[j * options + k] = best;
+        }
+      }
+      work += options * options * options;
+      add_edge_costs(y, z, folded);
+      remove_node(node);
+    }
+
+    bool PBQPSolver::solve(int64_t budget) {
+      int64_t node_count = node_costs.size();
+      std::priority_queue<std::tuple<double, int64_t, int64_t>, std::vector<std::tuple<double, int64_t, int64_t>>,
+          std::greater<std::tuple<double, int64_t, int64_t>>> spill_candidates;    // (priority / degree, id, degree)
+      for (int64_t node = 0; node < node_count; node++) {
+        if (degree[node] <= 2) low_degree.push_back(node);
+        else spill_candidates.push(std::make_tuple(priority[node] / degree[node], node, degree[node]));
+        allocatable.push_back(node);
+      }
+
+      for (int64_t remaining = node_count; remaining > 0; remaining--) {
+        if (work > budget) return false;
+
+        int64_t node = -1;
+        while (!low_degree.empty()) {
+          int64_t candidate = low_degree.back();
+          low_degree.pop_back();
+          if (!removed[candidate] && degree[candidate] <= 2) {
+            node = candidate;
+            break;
+          }
+        }
+        if (node != -1) {
+          if (degree[node] == 0) remove_node(node);
+          else if (degree[node] == 1) reduce_one(node);
+          else reduce_two(node);
+          continue;
+        }
+
+        /*
+        RN: every node left has degree 3 or more. Nodes with fewer neighbors than usable registers go first, like the
+        low degree nodes of simplify: taken out early, they are decided last and always find a register. Then the
+        cheapest node to spill per degree; heap entries go stale as degrees drop, those are pushed again.
+        */
+        while (!allocatable.empty()) {
+          int64_t candidate = allocatable.back();
+          allocatable.pop_back();
+          if (!removed[candidate] && provably_allocatable(candidate)) {
+            node = candidate;
+            break;
+          }
+        }
+        while (node == -1) {
+          auto top = spill_candidates.top();
+          spill_candidates.pop();
+          int64_t candidate = std::get<1>(top);
+          if (removed[candidate]) continue;
+          if (std::get<2>(top) != degree[candidate]) {
+            spill_candidates.push(std::make_tuple(priority[candidate] / degree[candidate], candidate, degree[candidate]));
+            continue;
+          }
+          node = candidate;
+        }
+        remove_node(node);
+      }
+
+      /*
+      Back propagation: every node's neighbors at the time it was taken out are decided by now.
+      */
+      solution.assign(node_count, 0);
+      for (auto it = reduced.rbegin(); it != reduced.rend(); it++) {
+        solution[it->first] = best_option(it->first, it->second);
+      }
+      return true;
+    }
+
+    /*
+    Registers in gp_registers order first, spilling only when it is strictly cheaper.
+    */
+    int64_t PBQPSolver::best_option(int64_t node, const std::vector<int64_t> &node_reduced_edges) const {
+      int64_t best = 1;
+      double best_cost = infinite_cost;
+      for (int64_t step = 1; step <= options; step++) {
+        int64_t option = step % options;
+        double cost = node_costs[node][option];
+        for (auto e : node_reduced_edges) {
+          cost += edge_cost(edges[e], node, option, solution[other_end(edges[e], node)]);
+        }
+        if (cost < best_cost) {
+          best = option;
+          best_cost = cost;
+        }
+      }
+      return best;
+    }
+
+    int64_t PBQPSolver::selection(int64_t node) const {
+      return solution[node];
+    }
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "L2.h"
+#include "interference_graph.h"
+
+namespace L2 {
+
+    /*
+    How much work the PBQP solver may do on one coloring attempt before it gives up and the coalescing allocator
+    colors the graph instead. It is counted rather than timed, so the output does not depend on the machine or its
+    load: one unit per edge a removal walks and per option combination a reduction folds (16 * 16 for RI,
+    16 * 16 * 16 for RII).
+    */
+    const int64_t pbqp_work_budget = 30000000;     // about two seconds of the -O0 build
+
+    /*
+    -O3 coloring: register allocation as a partitioned boolean quadratic problem (Scholz & Eckstein).
+    Same inputs and outputs as color_graph. Every variable picks one of 16 options, spill or one of gp_registers:
+    - node costs: its spill cost for the spill option, infinite for a register it interferes with (or for spilling a
+      spill temporary), the loop weight of every move to or from a register it wouldn't end up in.
+    - edge costs: infinite for two interfering variables in the same register, the loop weight of the move for two
+      move related variables in different registers (or spilled).
+    - when the budget runs out, or the problem has no finite solution, color_graph_coalescing does the job.
+    */
+    std::tuple<bool, std::vector<Node*>> color_graph_pbqp(Graph *graph, Graph *graph_copy, Function *fptr);
+
+    /*
+    Reduction based PBQP solver (Hames & Scholz): nodes of degree 0, 1 and 2 are reduced optimally (R0, RI, RII),
+    when none is left a node is taken out as is (RN) and gets the locally best option once its neighbors are decided:
+    one with fewer neighbors than usable registers if there is one, else the cheapest to spill per degree. Options are chosen in the reverse order of the reductions.
+    */
+    class PBQPSolver {
+      public:
+        static const int64_t options = 16;      // option 0 is spill, option k is gp_registers[k - 1]
+
+        int64_t add_node(const std::vector<double> &costs, double priority);
+        void add_edge_costs(int64_t u, int64_t v, const std::vector<double> &costs);   // options x options, u's option first
+        void add_interference(int64_t u, int64_t v);
+        bool solve(int64_t budget);     // false when the work budget ran out first
+        int64_t selection(int64_t node) const;
+
+      private:
+        struct Edge {
+          int64_t u;
+          int64_t v;
+          bool interferes = false;
+          bool alive = true;
+          std::vector<double> costs;    // empty when the edge is only an interference
+        };
+
+        int64_t find_or_add_edge(int64_t u, int64_t v);
+        double edge_cost(const Edge &edge, int64_t from, int64_t from_option, int64_t to_option) const;
+        int64_t other_end(const Edge &edge, int64_t node) const;
+        std::vector<int64_t> live_edges(int64_t node);
+        void remove_node(int64_t node);
+        bool provably_allocatable(int64_t node) const;
+        void reduce_one(int64_t node);
+        void reduce_two(int64_t node);
+        int64_t best_option(int64_t node, const std::vector<int64_t> &node_reduced_edges) const;
+
+        std::vector<std::vector<double>> node_costs;
+        std::vector<double> priority;           // lower is taken out first by RN
+        std::vector<std::vector<int64_t>> node_edges;
+        std::vector<int64_t> degree;
+        std::vector<bool> removed;
+        std::vector<Edge> edges;
+        std::unordered_map<uint64_t, int64_t> edge_index;
+        std::vector<int64_t> low_degree;        // nodes that may have degree 2 or less, checked when popped
+        std::vector<int64_t> allocatable;       // nodes that may be provably allocatable, checked when popped
+        std::vector<std::pair<int64_t, std::vector<int64_t>>> reduced;   // node, its edges when it was taken out
+        std::vector<int64_t> solution;
+        int64_t work = 0;                       // units of pbqp_work_budget spent so far
+    };
+
+}
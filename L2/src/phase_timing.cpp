@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <iomanip>
+
+#include "phase_timing.h"
+
+using namespace std;
+
+namespace L2 {
+
+    bool phase_timing = false;
+    bool function_timing = false;
+
+    static const char *phase_names[phase_count] = {
+      "parse",
+      "use/def",
+      "cfg",
+      "liveness",
+      "interference",
+      "coloring",
+      "spill",
+      "code generation"
+    };
+
+    static std::atomic<int64_t> phase_ns[phase_count];
+    static std::atomic<int64_t> phase_iterations[phase_count];
+    static std::atomic<int64_t> phase_bytes[phase_count];
+    static thread_local PhaseScope *innermost_scope = nullptr;
+
+    void PhaseScope::begin(Phase phase, double *function_ms) {
+      this->phase = phase;
+      this->function_ms = function_ms;
+      parent = innermost_scope;
+      innermost_scope = this;
+      nested_ns = 0;
+      nested_bytes = 0;
+      arena = Arena::current();
+      start_bytes = arena ? arena->bytes() : 0;
+      start = std::chrono::steady_clock::now();
+    }
+
+    void PhaseScope::end() {
+      int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+      int64_t bytes = (arena && arena == Arena::current()) ? (int64_t)arena->bytes() - start_bytes : 0;
+      innermost_scope = parent;
+      if (parent) {
+        parent->nested_ns += ns;
+        parent->nested_bytes += bytes;
+      }
+      if (function_ms && function_timing) *function_ms += ns / 1e6;
+      if (!phase_timing) return;
+      int p = (int)phase;
+      phase_ns[p] += ns - nested_ns;
+      phase_iterations[p]++;
+      phase_bytes[p] += bytes - nested_bytes;
+    }
+
+    void print_phase_report(std::ostream &out, bool json, double total_ms) {
+      if (json) {
+        out << "{\"compiler\": \"L2\", \"total_ms\": " << std::fixed << std::setprecision(3) << total_ms << ", \"phases\": [" << std::endl;
+        for (int p = 0; p < phase_count; p++) {
+          out << "{\"phase\": \"" << phase_names[p] << "\""
+              << ", \"ms\": " << phase_ns[p] / 1e6
+              << ", \"iterations\": " << phase_iterations[p]
+              << ", \"bytes\": " << phase_bytes[p] << "}"
+              << (p + 1 < phase_count ? "," : "") << std::endl;
+        }
+        out << "]}" << std::endl;
+        return;
+      }
+      double accounted_ms = 0;
+      out << std::left << std::setw(18) << "L2 phase" << std::right << std::setw(12) << "time (ms)" << std::setw(8) << "%"
+          << std::setw(12) << "iterations" << std::setw(14) << "arena bytes" << std::endl;
+      out << std::fixed << std::setprecision(3);
+      for (int p = 0; p < phase_count; p++) {
+        double ms = phase_ns[p] / 1e6;
+        accounted_ms += ms;
+        out << std::left << std::setw(18) << phase_names[p] << std::right << std::setw(12) << ms
+            << std::setw(7) << std::setprecision(1) << (total_ms > 0 ? 100 * ms / total_ms : 0) << "%"
+            << std::setprecision(3) << std::setw(12) << phase_iterations[p] << std::setw(14) << phase_bytes[p] << std::endl;
+      }
+      out << std::left << std::setw(18) << "other" << std::right << std::setw(12) << std::max(0.0, total_ms - accounted_ms) << std::endl;
+      out << std::left << std::setw(18) << "total" << std::right << std::setw(12) << total_ms << std::endl;
+    }
+
+}
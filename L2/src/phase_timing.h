@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "arena.h"
+
+namespace L2 {
+
+    /*
+    Where compile time goes, for -T.
+    - a PhaseScope charges the time and the arena bytes between its construction and its destruction to its phase,
+      minus what the scopes nested in it charge to theirs, so the phases never count the same time twice. Every
+      scope is one iteration of its phase (one liveness run, one coloring attempt, one spill round, ...).
+    - it can also add its time, nested scopes included, to a per function total of the -r report.
+    - with -T and -r off a PhaseScope only tests two flags; the totals are shared by the -j threads.
+    */
+    enum class Phase : uint8_t {
+      parse,
+      use_def,
+      cfg,
+      liveness,
+      interference,
+      coloring,
+      spill,
+      code_generation
+    };
+    const int phase_count = 8;
+
+    extern bool phase_timing;       // -T
+    extern bool function_timing;    // -r
+
+    class PhaseScope {
+        public:
+            PhaseScope(Phase phase, double *function_ms = nullptr)
+                : active(phase_timing || (function_ms && function_timing)) {
+              if (active) begin(phase, function_ms);
+            }
+            ~PhaseScope() {
+              if (active) end();
+            }
+
+        private:
+            void begin(Phase phase, double *function_ms);
+            void end();
+
+            bool active;
+            Phase phase;
+            double *function_ms;
+            PhaseScope *parent;
+            std::chrono::steady_clock::time_point start;
+            int64_t nested_ns;
+            Arena *arena;
+            int64_t start_bytes;
+            int64_t nested_bytes;
+    };
+
+    /*
+    The totals as a table, or as JSON with one phase per line; total_ms is the whole compilation.
+    */
+    void print_phase_report(std::ostream &out, bool json, double total_ms);
+
+}
@@ -0,0 +1,420 @@
+#include "register_coalescing.h"
+
+using namespace std;
+
+namespace L2 {
+
+    std::tuple<bool, std::vector<Node*>> color_graph_coalescing(Graph *graph, Graph *graph_copy, Function *fptr) {
+      /*
+      Registers keep their own color, exactly like in color_graph.
+      */
+      color_registers(graph_copy);
+
+      RegisterCoalescer coalescer(graph_copy, fptr);
+      return coalescer.color();
+    }
+
+    void remove_coalesced_moves(Function *fptr) {
+      std::vector<Instruction*> kept;
+      kept.reserve(fptr->instructions.size());
+      for (auto iptr : fptr->instructions) {
+        if (iptr->kind == InstructionKind::assignment) {
+          auto assignment = static_cast<Instruction_assignment*>(iptr);
+          auto d = as_variable(assignment->d);
+          auto s = as_variable(assignment->s);
+          if (d && s && d->print() == s->print()) {
+            if (debug) std::cerr << "dropping coalesced move " << d->print() << " <- " << s->print() << std::endl;
+            continue;
+          }
+        }
+        kept.push_back(iptr);
+      }
+      fptr->instructions = kept;
+      fptr->invalidate_analysis();
+    }
+
+    RegisterCoalescer::RegisterCoalescer(Graph *graph, Function *fptr)
+        : graph(graph), colors(gp_registers.size()) {
+      size_t node_count = graph->node_list.size();
+      state.assign(node_count, initial);
+      degree.assign(node_count, 0);
+      alias.assign(node_count, -1);
+      color_of.assign(node_count, -1);
+      spill_temporary.assign(node_count, false);
+      spill_cost.assign(node_count, 0);
+      move_list.assign(node_count, {});
+
+      for (auto node : graph->node_list) {
+        degree[node->id] = graph->adjacency[node->id].size();
+        spill_cost[node->id] = node->spill_cost;
+        if (dynamic_cast<Register*>(node->var)) {
+          state[node->id] = precolored;
+          auto position = std::find(gp_registers.begin(), gp_registers.end(), node->color);
+          if (position != gp_registers.end()) color_of[node->id] = position - gp_registers.begin();
+          continue;
+        }
+        /*
+        Same test repopulate uses to recognize the temporaries introduced by a spill.
+        */
+        auto node_name = node->var->name;
+        if (graph->spill_vars.count(node->var) || (node_name.size() > 1 && node_name[0] == '%' && node_name[1] == 'S')) {
+          spill_temporary[node->id] = true;
+        }
+      }
+
+      build_moves(fptr);
+      merge_register_copies();
+    }
+
+    /*
+    Collect the var <- var moves between two nodes of the graph.
+    - spill temporaries are left out: merging one into a long lived variable could force us to spill it again.
+    */
+    void RegisterCoalescer::build_moves(Function *fptr) {
+      for (auto iptr : fptr->instructions) {
+        if (iptr->kind != InstructionKind::assignment) continue;
+        auto assignment = static_cast<Instruction_assignment*>(iptr);
+        auto d = as_variable(assignment->d);
+        auto s = as_variable(assignment->s);
+        if (!d || !s) continue;
+        auto d_it = graph->nodes.find(d);
+        auto s_it = graph->nodes.find(s);
+        if (d_it == graph->nodes.end() || s_it == graph->nodes.end()) continue;
+        int64_t x = d_it->second->id;
+        int64_t y = s_it->second->id;
+        if (x == y || spill_temporary[x] || spill_temporary[y]) continue;
+
+        int64_t move = moves.size();
+        moves.push_back({x, y});
+        move_state.push_back(move_worklist);
+        worklist_moves.push_back(move);
+        move_list[x].push_back(move);
+        move_list[y].push_back(move);
+      }
+    }
+
+    /*
+    After a spill the instructions can hold several Register objects with the same name (the spiller clones items).
+    They are all the same physical register, so fold every copy into the first node of that name before we start;
+    otherwise a variable could be coalesced into one copy while interfering with another.
+    */
+    void RegisterCoalescer::merge_register_copies() {
+      std::map<std::string, int64_t> first_node;
+      for (auto node : graph->node_list) {
+        if (state[node->id] != precolored) continue;
+        auto inserted = first_node.insert({node->color, node->id});
+        if (inserted.second) continue;
+
+        int64_t u = inserted.first->second;
+        int64_t v = node->id;
+        state[v] = coalesced;
+        alias[v] = u;
+        move_list[u].insert(move_list[u].end(), move_list[v].begin(), move_list[v].end());
+        std::vector<int64_t> neighbors = adjacent(v);
+        for (auto t : neighbors) {
+          add_edge(t, u);
+          decrement_degree(t);
+        }
+      }
+    }
+
+    void RegisterCoalescer::make_worklists() {
+      for (auto node : graph->node_list) {
+        int64_t n = node->id;
+        if (state[n] != initial) continue;
+        if (degree[n] >= colors) {
+          push_node(n, spill_list);
+        } else if (move_related(n)) {
+          push_node(n, freeze_list);
+        } else {
+          push_node(n, simplify_list);
+        }
+      }
+    }
+
+    void RegisterCoalescer::push_node(int64_t n, NodeState new_state) {
+      state[n] = new_state;
+      switch (new_state) {
+        case simplify_list:
+          simplify_worklist.push_back(n);
+          break;
+        case freeze_list:
+          freeze_worklist.push_back(n);
+          break;
+        case spill_list:
+          spill_worklist.push(std::make_tuple(spill_cost[n] / degree[n], -degree[n], n));
+          break;
+        default:
+          break;
+      }
+    }
+
+    std::vector<int64_t> RegisterCoalescer::adjacent(int64_t n) const {
+      std::vector<int64_t> result;
+      for (auto t : graph->adjacency[n]) {
+        if (state[t] != selected && state[t] != coalesced) result.push_back(t);
+      }
+      return result;
+    }
+
+    std::vector<int64_t> RegisterCoalescer::node_moves(int64_t n) const {
+      std::vector<int64_t> result;
+      for (auto move : move_list[n]) {
+        if (move_state[move] == move_active || move_state[move] == move_worklist) result.push_back(move);
+      }
+      return result;
+    }
+
+    bool RegisterCoalescer::move_related(int64_t n) const {
+      for (auto move : move_list[n]) {
+        if (move_state[move] == move_active || move_state[move] == move_worklist) return true;
+      }
+      return false;
+    }
+
+    void RegisterCoalescer::add_edge(int64_t u, int64_t v) {
+      if (u == v || graph->hasEdge(u, v)) return;
+      graph->addEdge(graph->node_list[u], graph->node_list[v]);
+      degree[u]++;
+      degree[v]++;
+      if (state[u] == spill_list) push_node(u, spill_list);
+      if (state[v] == spill_list) push_node(v, spill_list);
+    }
+
+    void RegisterCoalescer::decrement_degree(int64_t m) {
+      if (state[m] == precolored) return;
+      int64_t d = degree[m];
+      degree[m] = d - 1;
+      if (state[m] != spill_list) return;
+      if (d == colors) {
+        enable_moves(m);
+        for (auto t : adjacent(m)) enable_moves(t);
+        push_node(m, move_related(m) ? freeze_list : simplify_list);
+      } else {
+        push_node(m, spill_list);
+      }
+    }
+
+    void RegisterCoalescer::enable_moves(int64_t n) {
+      for (auto move : move_list[n]) {
+        if (move_state[move] == move_active) {
+          move_state[move] = move_worklist;
+          worklist_moves.push_back(move);
+        }
+      }
+    }
+
+    int64_t RegisterCoalescer::get_alias(int64_t n) const {
+      while (state[n] == coalesced) n = alias[n];
+      return n;
+    }
+
+    void RegisterCoalescer::add_work_list(int64_t u) {
+      if (state[u] == freeze_list && !move_related(u) && degree[u] < colors) {
+        push_node(u, simplify_list);
+      }
+    }
+
+    /*
+    George test for merging v into the register r: every neighbor t of v is either trivially colorable or already conflicts with r.
+    */
+    bool RegisterCoalescer::george_ok(int64_t t, int64_t r) const {
+      return degree[t] < colors || state[t] == precolored || graph->hasEdge(t, r);
+    }
+
+    /*
+    Briggs test: the merged node has fewer than K neighbors of significant degree.
+    */
+    bool RegisterCoalescer::briggs_conservative(int64_t u, int64_t v) const {
+      std::vector<int64_t> neighbors = adjacent(u);
+      std::vector<int64_t> v_neighbors = adjacent(v);
+      neighbors.insert(neighbors.end(), v_neighbors.begin(), v_neighbors.end());
+      std::sort(neighbors.begin(), neighbors.end());
+      neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+      int64_t significant = 0;
+      for (auto n : neighbors) {
+        if (state[n] == precolored || degree[n] >= colors) significant++;
+      }
+      return significant < colors;
+    }
+
+    void RegisterCoalescer::combine(int64_t u, int64_t v) {
+      state[v] = coalesced;
+      alias[v] = u;
+      spill_cost[u] += spill_cost[v];
+      move_list[u].insert(move_list[u].end(), move_list[v].begin(), move_list[v].end());
+      enable_moves(v);
+      for (auto t : adjacent(v)) {
+        add_edge(t, u);
+        decrement_degree(t);
+      }
+      if (degree[u] >= colors && state[u] == freeze_list) {
+        push_node(u, spill_list);
+      }
+    }
+
+    void RegisterCoalescer::simplify() {
+      int64_t n = simplify_worklist.back();
+      simplify_worklist.pop_back();
+      if (state[n] != simplify_list) return;
+
+      state[n] = selected;
+      select_stack.push_back(n);
+      for (auto m : adjacent(n)) {
+        decrement_degree(m);
+      }
+    }
+
+    void RegisterCoalescer::coalesce() {
+      int64_t move = worklist_moves.back();
+      worklist_moves.pop_back();
+      if (move_state[move] != move_worklist) return;
+
+      int64_t x = get_alias(moves[move].first);
+      int64_t y = get_alias(moves[move].second);
+      int64_t u = x, v = y;
+      if (state[y] == precolored) {
+        u = y;
+        v = x;
+      }
+
+      if (u == v) {
+        move_state[move] = move_coalesced;
+        add_work_list(u);
+      } else if (state[v] == precolored || graph->hasEdge(u, v)) {
+        move_state[move] = move_constrained;
+        add_work_list(u);
+        add_work_list(v);
+      } else {
+        bool can_merge;
+        if (state[u] == precolored) {
+          can_merge = true;
+          for (auto t : adjacent(v)) {
+            if (!george_ok(t, u)) {
+              can_merge = false;
+              break;
+            }
+          }
+        } else {
+          can_merge = briggs_conservative(u, v);
+        }
+
+        if (can_merge) {
+          move_state[move] = move_coalesced;
+          combine(u, v);
+          add_work_list(u);
+        } else {
+          move_state[move] = move_active;
+        }
+      }
+    }
+
+    void RegisterCoalescer::freeze() {
+      int64_t u = freeze_worklist.back();
+      freeze_worklist.pop_back();
+      if (state[u] != freeze_list) return;
+
+      push_node(u, simplify_list);
+      freeze_moves(u);
+    }
+
+    void RegisterCoalescer::freeze_moves(int64_t u) {
+      for (auto move : node_moves(u)) {
+        int64_t x = moves[move].first;
+        int64_t y = moves[move].second;
+        int64_t v = (get_alias(y) == get_alias(u)) ? get_alias(x) : get_alias(y);
+        move_state[move] = move_frozen;
+        if (state[v] == freeze_list && !move_related(v) && degree[v] < colors) {
+          push_node(v, simplify_list);
+        }
+      }
+    }
+
+    void RegisterCoalescer::select_spill() {
+      /*
+      Same heuristic as depopulate: the lowest spill cost / degree. Spill temporaries cost infinity so they go last.
+      - entries whose degree or state changed since they were queued are stale and skipped.
+      */
+      auto top = spill_worklist.top();
+      spill_worklist.pop();
+      int64_t m = std::get<2>(top);
+      if (state[m] != spill_list || degree[m] != -std::get<1>(top)) return;
+
+      push_node(m, simplify_list);
+      freeze_moves(m);
+    }
+
+    std::tuple<bool, std::vector<Node*>> RegisterCoalescer::color() {
+      make_worklists();
+
+      while (true) {
+        if (!simplify_worklist.empty()) {
+          simplify();
+        } else if (!worklist_moves.empty()) {
+          coalesce();
+        } else if (!freeze_worklist.empty()) {
+          freeze();
+        } else if (!spill_worklist.empty()) {
+          select_spill();
+        } else {
+          break;
+        }
+      }
+
+      return assign_colors();
+    }
+
+    std::tuple<bool, std::vector<Node*>> RegisterCoalescer::assign_colors() {
+      bool failed_to_color = false;
+      std::vector<Node*> uncolored_nodes;
+
+      while (!select_stack.empty()) {
+        int64_t n = select_stack.back();
+        select_stack.pop_back();
+
+        std::vector<bool> taken(colors, false);
+        for (auto w : graph->adjacency[n]) {
+          int64_t a = get_alias(w);
+          if ((state[a] == colored || state[a] == precolored) && color_of[a] >= 0) {
+            taken[color_of[a]] = true;
+          }
+        }
+
+        for (int64_t c = 0; c < colors; c++) {
+          if (!taken[c]) {
+            color_of[n] = c;
+            break;
+          }
+        }
+
+        Node* node = graph->node_list[n];
+        if (color_of[n] == -1) {
+          /*
+          Spill conditions, same as repopulate: spill temporaries are never handed back to the spiller.
+          */
+          failed_to_color = true;
+          if (!spill_temporary[n]) uncolored_nodes.push_back(node);
+          continue;
+        }
+        state[n] = colored;
+        node->color = gp_registers[color_of[n]];
+      }
+
+      /*
+      Coalesced nodes share the color of the node they were merged into.
+      */
+      for (auto node : graph->node_list) {
+        int64_t n = node->id;
+        if (state[n] != coalesced) continue;
+        int64_t a = get_alias(n);
+        if (color_of[a] >= 0) node->color = gp_registers[color_of[a]];
+      }
+
+      if (debug) std::cerr << "coalesced " << std::count(move_state.begin(), move_state.end(), move_coalesced) << " of " << moves.size() << " moves" << std::endl;
+
+      bool big_fail = failed_to_color && uncolored_nodes.size() == 0;
+      return std::make_tuple(big_fail, uncolored_nodes);
+    }
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <queue>
+
+#include "L2.h"
+#include "interference_graph.h"
+
+namespace L2 {
+
+    /*
+    Coloring with iterated register coalescing (George & Appel).
+    Same inputs and outputs as color_graph, but variable-to-variable moves get coalesced while the graph is simplified:
+    - two move related nodes are merged when the Briggs test (or the George test, when one of them is a register) says
+      the merged node can't make the graph harder to color.
+    - a coalesced node takes the color of the node it was merged into, so the move turns into a self move that
+      remove_coalesced_moves can drop after coloring.
+    */
+    std::tuple<bool, std::vector<Node*>> color_graph_coalescing(Graph *graph, Graph *graph_copy, Function *fptr);
+
+    /*
+    Deletes the moves whose source and destination ended up with the same color. Call after ColorVariablesVisitor.
+    */
+    void remove_coalesced_moves(Function *fptr);
+
+    /*
+    Worklist state of the iterated coalescing algorithm, all indexed by node id of the graph being colored.
+    - node and move worklists are plain vectors with lazy deletion: an entry only counts if the state still matches.
+    */
+    class RegisterCoalescer {
+      public:
+        RegisterCoalescer(Graph *graph, Function *fptr);
+        std::tuple<bool, std::vector<Node*>> color();
+
+      private:
+        enum NodeState { precolored, initial, simplify_list, freeze_list, spill_list, coalesced, selected, colored };
+        enum MoveState { move_worklist, move_active, move_coalesced, move_constrained, move_frozen };
+
+        void build_moves(Function *fptr);
+        void merge_register_copies();
+        void make_worklists();
+        void push_node(int64_t n, NodeState new_state);
+        std::vector<int64_t> adjacent(int64_t n) const;
+        std::vector<int64_t> node_moves(int64_t n) const;
+        bool move_related(int64_t n) const;
+        void add_edge(int64_t u, int64_t v);
+        void decrement_degree(int64_t m);
+        void enable_moves(int64_t n);
+        int64_t get_alias(int64_t n) const;
+        void add_work_list(int64_t u);
+        bool george_ok(int64_t t, int64_t r) const;
+        bool briggs_conservative(int64_t u, int64_t v) const;
+        void combine(int64_t u, int64_t v);
+        void simplify();
+        void coalesce();
+        void freeze();
+        void select_spill();
+        void freeze_moves(int64_t u);
+        std::tuple<bool, std::vector<Node*>> assign_colors();
+
+        Graph *graph;
+        int64_t colors;
+        std::vector<NodeState> state;
+        std::vector<int64_t> degree;
+        std::vector<int64_t> alias;
+        std::vector<int64_t> color_of;             // index into gp_registers, -1 if uncolored
+        std::vector<bool> spill_temporary;         // %S variables created by the spiller, never coalesced or spilled again
+        std::vector<std::vector<int64_t>> move_list;
+        std::vector<std::pair<int64_t, int64_t>> moves;    // (destination, source) node ids
+        std::vector<MoveState> move_state;
+        std::vector<int64_t> simplify_worklist;
+        std::vector<int64_t> freeze_worklist;
+        std::vector<int64_t> worklist_moves;
+        std::vector<double> spill_cost;            // Node::spill_cost, summed over the nodes coalesced together
+        std::priority_queue<std::tuple<double, int64_t, int64_t>, std::vector<std::tuple<double, int64_t, int64_t>>,
+            std::greater<std::tuple<double, int64_t, int64_t>>> spill_worklist;     // (cost / degree, -degree, id)
+        std::vector<int64_t> select_stack;
+    };
+
+}
@@ -0,0 +1,120 @@
+#include "shrink_wrapping.h"
+
+using namespace std;
+
+namespace L2 {
+
+    static const std::vector<std::string> callee_saved_registers{
+        "r12",
+        "r13",
+        "r14",
+        "r15",
+        "rbp",
+        "rbx"
+    };
+
+    static int64_t common_dominator(const ControlFlowGraph &cfg, int64_t a, int64_t b) {
+      while (a != b) {
+        while (cfg.rpo_index[a] > cfg.rpo_index[b]) a = cfg.idom[a];
+        while (cfg.rpo_index[b] > cfg.rpo_index[a]) b = cfg.idom[b];
+      }
+      return a;
+    }
+
+    /*
+    The closest block at or above block in the dominator tree that no loop contains, so a save there runs once.
+    */
+    static int64_t outside_loops(const ControlFlowGraph &cfg, int64_t block) {
+      while (block != 0 && cfg.loop_of[block] != -1) {
+        int64_t loop = cfg.loop_of[block];
+        while (cfg.loops[loop].parent != -1) loop = cfg.loops[loop].parent;
+        block = cfg.idom[cfg.loops[loop].header];
+      }
+      return block;
+    }
+
+    void shrink_wrap_callee_saves(Function *fptr) {
+      fptr->invalidate_analysis();
+      fptr->calculateUseDefs();
+      const ControlFlowGraph &cfg = fptr->control_flow();
+      int64_t blocks = cfg.block_count();
+
+      std::vector<int64_t> return_blocks;
+      for (int64_t b = 0; b < blocks; b++) {
+        if (cfg.rpo_index[b] != -1 && fptr->instructions[cfg.block_last[b]]->kind == InstructionKind::ret) {
+          return_blocks.push_back(b);
+        }
+      }
+
+      /*
+      What to put before each instruction: saves at the start of their block (after its label, but before the
+      label of the entry so jumps back to it don't save again), restores before the returns.
+      */
+      std::vector<std::vector<Instruction*>> inserted(fptr->instructions.size());
+      Variable *rsp = fptr->variable_allocator.allocate_variable("rsp", VariableType::reg);
+      int64_t saved = 0;
+      for (auto &register_name : callee_saved_registers) {
+        int64_t save_block = -1;
+        for (size_t i = 0; i < fptr->instructions.size(); i++) {
+          int64_t block = cfg.block_of[i];
+          if (cfg.rpo_index[block] == -1) continue;
+          for (auto var : fptr->tables.defs(i)) {
+            if (var->print() != register_name) continue;
+            save_block = (save_block == -1) ? block : common_dominator(cfg, save_block, block);
+          }
+        }
+        if (save_block == -1) continue;
+
+        /*
+        Every return reachable from the save has to be one that can't be reached without it, and the save block
+        must not reach itself: an irreducible cycle has no loop in the CFG, so outside_loops can't see it.
+        */
+        while (true) {
+          save_block = outside_loops(cfg, save_block);
+          std::vector<bool> reached(blocks, false);
+          std::vector<int64_t> worklist(cfg.successors[save_block].begin(), cfg.successors[save_block].end());
+          for (auto next : worklist) reached[next] = true;
+          while (!worklist.empty()) {
+            int64_t block = worklist.back();
+            worklist.pop_back();
+            for (auto next : cfg.successors[block]) {
+              if (!reached[next]) {
+                reached[next] = true;
+                worklist.push_back(next);
+              }
+            }
+          }
+          bool wrapped = !reached[save_block];
+          reached[save_block] = true;
+          for (auto block : return_blocks) {
+            if (reached[block] && !cfg.dominates(save_block, block)) wrapped = false;
+          }
+          if (wrapped || save_block == 0) {
+            Variable *reg = fptr->variable_allocator.allocate_variable(register_name, VariableType::reg);
+            int64_t offset = (fptr->locals + saved) * 8;
+            int64_t position = cfg.block_first[save_block];
+            if (save_block != 0 && fptr->instructions[position]->kind == InstructionKind::label) position++;
+            inserted[position].push_back(new Memory_assignment_store(rsp, reg, new Number(offset)));
+            for (auto block : return_blocks) {
+              if (reached[block]) inserted[cfg.block_last[block]].push_back(new Memory_assignment_load(reg, rsp, new Number(offset)));
+            }
+            break;
+          }
+          save_block = cfg.idom[save_block];
+        }
+        saved++;
+      }
+      if (saved == 0) return;
+
+      std::vector<Instruction*> rewritten;
+      for (size_t i = 0; i < fptr->instructions.size(); i++) {
+        rewritten.insert(rewritten.end(), inserted[i].begin(), inserted[i].end());
+        rewritten.push_back(fptr->instructions[i]);
+      }
+      fptr->instructions = rewritten;
+      fptr->locals += saved;
+      fptr->stats.callee_saves += saved;
+      fptr->invalidate_analysis();
+    }
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "L2.h"
+
+namespace L2 {
+
+    /*
+    Shrink-wrapped saves of the callee-saved registers, run once registers and stack slots are allocated.
+    - with Function::shrink_wrap set, liveness leaves the callee-saved registers out of "return", so the allocator
+      hands them out like any other register (after the caller-saved ones) and this pass saves the ones it wrote.
+    - each written register gets a stack slot above the spill slots. It is saved once, at the nearest block that
+      dominates every write and is on no cycle (loop or irreducible), and restored before each return that block
+      reaches.
+    - when a return can be reached both with and without passing the save, the save moves up the dominator tree
+      until it can't (at the latest the entry). Paths that never write the register, like early exits, skip the
+      save and the restore.
+    */
+    void shrink_wrap_callee_saves(Function *fptr);
+
+}
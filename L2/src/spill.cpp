@@ -3,6 +3,7 @@
 #include <string>
 #include <stack>
 #include <tuple>
+#include <unordered_map>
 
 #include <L2.h>
 #include <graph_coloring.h>
@@ -102,4 +103,320 @@ namespace L2{
     }
 
 
-    }
\ No newline at end of file
+    
+    /*
+    Offset of a "mem rsp N" access with N >= 0 (a stack slot), -1 otherwise.
+    */
+    static int64_t stack_slot(Item* base, Item* M) {
+        auto base_var = as_variable(base);
+        auto offset = as_number(M);
+        if (!base_var || !offset || base_var->print() != "rsp" || offset->value < 0) return -1;
+        return offset->value;
+    }
+
+    void reuse_spill_reloads(Function* f) {
+        /*
+        The use/def tables were dropped by the spiller (or describe variables since renamed to their registers).
+        Rebuild them so the instructions created by the spiller are covered too.
+        */
+        f->calculateUseDefs();
+
+        /*
+        For every slot, the registers known to hold the same value as the slot right now.
+        */
+        std::map<int64_t, std::set<std::string>> holders;
+        auto forget_register = [&](const std::string& reg) {
+            for (auto& slot : holders) slot.second.erase(reg);
+        };
+
+        std::vector<Instruction*> kept;
+        kept.reserve(f->instructions.size());
+        int64_t removed_loads = 0, removed_stores = 0;
+        for (size_t position = 0; position < f->instructions.size(); position++) {
+            Instruction* instruction = f->instructions[position];
+            auto load = (instruction->kind == InstructionKind::memory_load) ? static_cast<Memory_assignment_load*>(instruction) : nullptr;
+            auto store = (instruction->kind == InstructionKind::memory_store) ? static_cast<Memory_assignment_store*>(instruction) : nullptr;
+            int64_t slot = -1;
+            if (load) slot = stack_slot(load->x, load->M);
+            if (store) slot = stack_slot(store->dst, store->M);
+
+            if (load && slot != -1) {
+                std::string reg = as_variable(load->dst)->print();
+                auto& slot_holders = holders[slot];
+                if (slot_holders.count(reg)) {
+                    removed_loads++;
+                    continue;
+                }
+                if (!slot_holders.empty()) {
+                    Variable* source = f->variable_allocator.allocate_variable(*slot_holders.begin(), VariableType::reg);
+                    Variable* destination = f->variable_allocator.allocate_variable(reg, VariableType::reg);
+                    instruction = new Instruction_assignment(destination, source);
+                    removed_loads++;
+                }
+                forget_register(reg);
+                holders[slot].insert(reg);
+                kept.push_back(instruction);
+                continue;
+            }
+
+            if (store && slot != -1) {
+                auto source = as_variable(store->s);
+                auto& slot_holders = holders[slot];
+                if (source && slot_holders.count(source->print())) {
+                    removed_stores++;
+                    continue;
+                }
+                slot_holders.clear();
+                if (source) slot_holders.insert(source->print());
+                kept.push_back(instruction);
+                continue;
+            }
+
+            /*
+            Anything else: a label starts a new block (other predecessors may reach it), a call clobbers registers
+            we don't track in the def sets, and an arithmetic store to a slot changes its value.
+            */
+            if (instruction->kind == InstructionKind::label || is_call(instruction)) {
+                holders.clear();
+            }
+            if (instruction->kind == InstructionKind::memory_arithmetic_store) {
+                auto arithmetic_store = static_cast<Memory_arithmetic_store*>(instruction);
+                int64_t arithmetic_slot = stack_slot(arithmetic_store->dst, arithmetic_store->M);
+                if (arithmetic_slot != -1) holders.erase(arithmetic_slot);
+            }
+            for (auto var : f->tables.defs(position)) {
+                forget_register(var->print());
+            }
+            kept.push_back(instruction);
+        }
+
+        if (debug) std::cerr << f->name << ": removed " << removed_loads << " reloads and " << removed_stores << " stores" << std::endl;
+        f->stats.spill_loads -= removed_loads;
+        f->stats.spill_stores -= removed_stores;
+        f->instructions = kept;
+        f->invalidate_analysis();
+    }
+
+
+    /*
+    The value a variable can be recomputed from when its single definition is "var <- N", "var <- :label" or "var <- @fn".
+    */
+    static Item* rematerializable_value(Instruction* definition) {
+        if (definition->kind != InstructionKind::assignment) return nullptr;
+        auto assignment = static_cast<Instruction_assignment*>(definition);
+        ItemKind source = assignment->s->kind;
+        if (source == ItemKind::number || source == ItemKind::label || source == ItemKind::name) {
+            return assignment->s;
+        }
+        return nullptr;
+    }
+
+    std::tuple<std::set<std::string>,int,int> spill_variables(Function* f, const std::vector<Variable*>& spilled, int spill_count, int stack_count,
+        std::vector<SpillRewrite>* rewrites) {
+
+        /*
+        The tables are still valid after an earlier spill_variables (it patches them), so a spill round after the
+        first one doesn't walk every instruction again.
+        */
+        if (!f->tables.use_defs_valid || f->tables.used.size() != f->instructions.size()) f->calculateUseDefs();
+
+        /*
+        How every spilled variable is brought back: from its own stack slot, or recomputed from its value when it is
+        rematerializable (then it needs no slot and its definition goes away).
+        */
+        struct SpilledVariable {
+            Item* value = nullptr;
+            Instruction* definition = nullptr;
+            int64_t definitions = 0;
+            int64_t offset = -1;
+        };
+        std::unordered_map<std::string, SpilledVariable> spills;
+        for (auto var : spilled) {
+            spills[var->name];
+        }
+        for (size_t position = 0; position < f->instructions.size(); position++) {
+            for (auto defined : f->tables.defs(position)) {
+                auto it = spills.find(defined->name);
+                if (it == spills.end()) continue;
+                it->second.definitions++;
+                it->second.definition = f->instructions[position];
+            }
+        }
+        for (auto var : spilled) {
+            auto& spill = spills[var->name];
+            if (spill.offset != -1 || spill.value) continue;
+            if (spill.definitions == 1) spill.value = rematerializable_value(spill.definition);
+            if (spill.value) {
+                f->stats.rematerialized++;
+                if (debug) std::cerr << "rematerializing " << var->name << " <- " << spill.value->print() << std::endl;
+            } else {
+                spill.offset = (int64_t)stack_count * 8;
+            }
+            stack_count++;
+            f->variable_allocator.remove_variable(var->name);
+        }
+
+        Variable* rsp = f->variable_allocator.allocate_variable("rsp", VariableType::reg);
+        std::set<std::string> spill_variables;
+        SpillRewriteVisitor rewrite;
+        std::vector<Instruction*> rewritten;
+        std::vector<OperandList> used, defined;     // the use/def tables of rewritten
+        rewritten.reserve(f->instructions.size());
+        used.reserve(f->instructions.size());
+        defined.reserve(f->instructions.size());
+        UseDefVisitor use_defs;
+        for (int64_t position = 0; position < (int64_t)f->instructions.size(); position++) {
+            Instruction* instruction = f->instructions[position];
+            /*
+            The spilled variables this instruction touches, each gets one fresh %S temporary for its uses and defs.
+            */
+            std::map<std::string, std::pair<bool, bool>> touched;   // name -> (used, defined)
+            for (auto var : f->tables.uses(position)) {
+                if (spills.count(var->name)) touched[var->name].first = true;
+            }
+            for (auto var : f->tables.defs(position)) {
+                if (spills.count(var->name)) touched[var->name].second = true;
+            }
+            if (touched.empty()) {
+                rewritten.push_back(instruction);
+                used.push_back(f->tables.used[position]);
+                defined.push_back(f->tables.defined[position]);
+                continue;
+            }
+            size_t first_new = rewritten.size();
+
+            bool drop = false;
+            SpillRewrite record;
+            record.position = position;
+            rewrite.replacements.clear();
+            std::vector<Instruction*> stores;
+            for (auto& [name, access] : touched) {
+                auto& spill = spills[name];
+                if (spill.value && spill.definition == instruction) {
+                    drop = true;
+                    continue;
+                }
+                std::string temporary_name = "%S" + std::to_string(spill_count++);
+                Variable* temporary = f->variable_allocator.allocate_variable(temporary_name, VariableType::var);
+                f->spill_variables_set.insert(temporary);
+                spill_variables.insert(temporary_name);
+                rewrite.replacements[name] = temporary;
+
+                if (access.first) {
+                    record.before.push_back(temporary);
+                    if (spill.value) {
+                        rewritten.push_back(new Instruction_assignment(temporary, spill.value->clone()));
+                    } else {
+                        rewritten.push_back(new Memory_assignment_load(temporary, rsp, new Number(spill.offset)));
+                        f->stats.spill_loads++;
+                    }
+                }
+                if (access.second && !spill.value) {
+                    record.after.push_back(temporary);
+                    stores.push_back(new Memory_assignment_store(rsp, temporary, new Number(spill.offset)));
+                    f->stats.spill_stores++;
+                }
+            }
+            record.dropped = drop;
+            if (rewrites) rewrites->push_back(record);
+            if (!drop) {
+                instruction->accept(&rewrite);
+                rewritten.push_back(instruction);
+                rewritten.insert(rewritten.end(), stores.begin(), stores.end());
+            }
+
+            /*
+            Only the instructions this position turned into need their operands read again.
+            */
+            used.resize(rewritten.size());
+            defined.resize(rewritten.size());
+            for (size_t k = first_new; k < rewritten.size(); k++) {
+                use_defs.used = &used[k];
+                use_defs.defined = &defined[k];
+                rewritten[k]->accept(&use_defs);
+            }
+        }
+        f->instructions = rewritten;
+        f->invalidate_control_flow();
+        f->tables.used = std::move(used);
+        f->tables.defined = std::move(defined);
+
+        return std::make_tuple(spill_variables, spill_count, stack_count);
+    }
+
+    void SpillRewriteVisitor::rename(Item*& item) {
+        auto var = as_variable(item);
+        if (!var) return;
+        auto it = replacements.find(var->name);
+        if (it != replacements.end()) item = it->second;
+    }
+    void SpillRewriteVisitor::visit(Instruction_ret *instruction) {
+    }
+    void SpillRewriteVisitor::visit(Instruction_assignment *instruction) {
+        rename(instruction->d);
+        rename(instruction->s);
+    }
+    void SpillRewriteVisitor::visit(label_Instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(goto_label_instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(Call_tenserr_Instruction *instruction) {
+        rename(instruction->F);
+    }
+    void SpillRewriteVisitor::visit(Call_uN_Instruction *instruction) {
+        rename(instruction->u);
+    }
+    void SpillRewriteVisitor::visit(Call_print_Instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(Call_input_Instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(Call_allocate_Instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(Call_tuple_Instruction *instruction) {
+    }
+    void SpillRewriteVisitor::visit(w_increment_decrement *instruction) {
+        rename(instruction->r);
+    }
+    void SpillRewriteVisitor::visit(w_atreg_assignment *instruction) {
+        rename(instruction->r1);
+        rename(instruction->r2);
+        rename(instruction->r3);
+    }
+    void SpillRewriteVisitor::visit(Memory_assignment_store *instruction) {
+        rename(instruction->dst);
+        rename(instruction->s);
+    }
+    void SpillRewriteVisitor::visit(Memory_assignment_load *instruction) {
+        rename(instruction->dst);
+        rename(instruction->x);
+    }
+    void SpillRewriteVisitor::visit(Memory_arithmetic_load *instruction) {
+        rename(instruction->dst);
+        rename(instruction->x);
+    }
+    void SpillRewriteVisitor::visit(Memory_arithmetic_store *instruction) {
+        rename(instruction->dst);
+        rename(instruction->t);
+    }
+    void SpillRewriteVisitor::visit(cmp_Instruction *instruction) {
+        rename(instruction->dst);
+        rename(instruction->t1);
+        rename(instruction->t2);
+    }
+    void SpillRewriteVisitor::visit(cjump_cmp_Instruction *instruction) {
+        rename(instruction->t1);
+        rename(instruction->t2);
+    }
+    void SpillRewriteVisitor::visit(stackarg_assignment *instruction) {
+        rename(instruction->w);
+    }
+    void SpillRewriteVisitor::visit(AOP_assignment *instruction) {
+        rename(instruction->dst);
+        rename(instruction->src);
+    }
+    void SpillRewriteVisitor::visit(SOP_assignment *instruction) {
+        rename(instruction->dst);
+        rename(instruction->src);
+    }
+
+}
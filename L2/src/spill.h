@@ -4,6 +4,8 @@
 #include "L2.h" 
 
 namespace L2 {
+    class Item;
+
     /**
      * Performs spilling for a variable in an L2 program.
      * 
@@ -12,4 +14,42 @@ namespace L2 {
      */
     // bool spillForL2(Program &p, Variable* spilledVar);
     std::tuple<std::set<std::string>,Function*,int> spillForL2(Function* f, Variable* spilledVar, int spill_count,int stack_count);
+
+    /**
+     * What spill_variables did to one instruction, so the analysis of the function before the spill can be patched
+     * (see update_analysis_after_spill) instead of being redone.
+     */
+    struct SpillRewrite {
+        int64_t position;                   // position of the instruction before the spill
+        bool dropped = false;               // a rematerialized definition, deleted
+        std::vector<Variable*> before;      // temporaries loaded or rematerialized right before it, in order
+        std::vector<Variable*> after;       // temporaries stored right after it, in order
+    };
+
+    /**
+     * Spills a whole set of variables at once, rewriting the function in place in a single pass.
+     * - each spilled variable gets its own stack slot; an instruction that touches it reads it into a fresh %S
+     *   temporary before and writes the temporary back after, like spillForL2.
+     * - a variable whose only definition is "var <- N", "var <- :label" or "var <- @fn" is rematerialized instead:
+     *   the definition is dropped and every use gets the value assigned to its temporary right before, no slot needed.
+     *
+     * @param f The function to rewrite.
+     * @param spilled The variables to spill.
+     * @param spill_count The number of the next %S temporary.
+     * @param stack_count The number of stack slots already in use.
+     * @param rewrites If not null, gets one entry per instruction that was changed, in order.
+     * @return The names of the new temporaries, and the updated spill_count and stack_count.
+     */
+    std::tuple<std::set<std::string>,int,int> spill_variables(Function* f, const std::vector<Variable*>& spilled, int spill_count, int stack_count,
+        std::vector<SpillRewrite>* rewrites = nullptr);
+
+    /**
+     * Cleans up the spill code once every variable has a register.
+     * Inside a basic block, a reload from a stack slot whose value is still sitting in a register becomes a move from
+     * that register (or disappears when it's the same register), and a store that writes back the value the slot
+     * already holds is dropped.
+     *
+     * @param f The register allocated function, rewritten in place.
+     */
+    void reuse_spill_reloads(Function* f);
 }
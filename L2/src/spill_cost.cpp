@@ -0,0 +1,50 @@
+#include <cmath>
+#include <limits>
+
+#include "spill_cost.h"
+
+using namespace std;
+
+namespace L2 {
+
+    std::vector<int64_t> loop_depths(Function *fptr) {
+      const ControlFlowGraph &cfg = fptr->control_flow();
+      std::vector<int64_t> depths(fptr->instructions.size(), 0);
+      for (int64_t b = 0; b < cfg.block_count(); b++) {
+        int64_t depth = cfg.loop_depth(b);
+        for (int64_t i = cfg.block_first[b]; i <= cfg.block_last[b]; i++) {
+          depths[i] = depth;
+        }
+      }
+      return depths;
+    }
+
+    void compute_spill_costs(Function *fptr, Graph *graph) {
+      std::vector<int64_t> depths = loop_depths(fptr);
+
+      for (auto node : graph->node_list) {
+        node->spill_cost = 0;
+      }
+
+      for (size_t i = 0; i < fptr->instructions.size(); i++) {
+        double weight = std::pow(10.0, (double)depths[i]);
+        for (auto var : fptr->tables.uses(i)) {
+          auto it = graph->nodes.find(var);
+          if (it != graph->nodes.end()) it->second->spill_cost += weight;
+        }
+        for (auto var : fptr->tables.defs(i)) {
+          auto it = graph->nodes.find(var);
+          if (it != graph->nodes.end()) it->second->spill_cost += weight;
+        }
+      }
+
+      for (auto node : graph->node_list) {
+        auto node_name = node->var->name;
+        bool spill_temporary = graph->spill_vars.count(node->var)
+            || (node_name.size() > 1 && node_name[0] == '%' && node_name[1] == 'S');
+        if (spill_temporary) node->spill_cost = std::numeric_limits<double>::infinity();
+        if (debug) std::cerr << "spill cost of " << node_name << ": " << node->spill_cost << std::endl;
+      }
+    }
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "L2.h"
+#include "interference_graph.h"
+
+namespace L2 {
+
+    /*
+    Loop nesting depth of every instruction, by position: the depth of its block in the loop nesting forest of
+    the function's CFG (0 outside loops and in unreachable code).
+    */
+    std::vector<int64_t> loop_depths(Function *fptr);
+
+    /*
+    Fills in Node::spill_cost for every variable node of the graph:
+    - each use or def counts 10^loop-depth, so variables touched inside inner loops are the most expensive to spill.
+    - temporaries created by a previous spill get infinite cost, spilling them again can't help.
+    */
+    void compute_spill_costs(Function *fptr, Graph *graph);
+
+}
@@ -0,0 +1,185 @@
+#include "stack_slots.h"
+
+using namespace std;
+
+namespace L2 {
+
+    /*
+    The rsp relative access an instruction makes, if any.
+    */
+    struct SlotAccess {
+      Item **M = nullptr;
+      bool use = false;
+      bool def = false;
+    };
+
+    static bool is_rsp(Item *item) {
+      auto var = as_variable(item);
+      return var && var->print() == "rsp";
+    }
+
+    static SlotAccess slot_access(Instruction *iptr) {
+      SlotAccess access;
+      switch (iptr->kind) {
+        case InstructionKind::memory_store: {
+          auto store = static_cast<Memory_assignment_store*>(iptr);
+          if (is_rsp(store->dst)) {
+            access.M = &store->M;
+            access.def = true;
+          }
+          break;
+        }
+        case InstructionKind::memory_load: {
+          auto load = static_cast<Memory_assignment_load*>(iptr);
+          if (is_rsp(load->x)) {
+            access.M = &load->M;
+            access.use = true;
+          }
+          break;
+        }
+        case InstructionKind::memory_arithmetic_load: {
+          auto arithmetic_load = static_cast<Memory_arithmetic_load*>(iptr);
+          if (is_rsp(arithmetic_load->x)) {
+            access.M = &arithmetic_load->M;
+            access.use = true;
+          }
+          break;
+        }
+        case InstructionKind::memory_arithmetic_store: {
+          auto arithmetic_store = static_cast<Memory_arithmetic_store*>(iptr);
+          if (is_rsp(arithmetic_store->dst)) {
+            access.M = &arithmetic_store->M;
+            access.use = true;
+            access.def = true;
+          }
+          break;
+        }
+        default:
+          break;
+      }
+      if (access.M) {
+        auto number = as_number(*access.M);
+        if (!number || number->value < 0) access = SlotAccess();
+      }
+      return access;
+    }
+
+    void allocate_stack_slots(Function *fptr) {
+      int64_t n = fptr->instructions.size();
+
+      /*
+      Number the slots and remember which slot every instruction touches.
+      */
+      std::vector<SlotAccess> accesses(n);
+      std::vector<int64_t> slot_at(n, -1);
+      std::map<int64_t, int64_t> slot_of_offset;
+      std::vector<int64_t> offsets;
+      bool aligned = true;
+      for (int64_t i = 0; i < n; i++) {
+        accesses[i] = slot_access(fptr->instructions[i]);
+        if (!accesses[i].M) continue;
+        int64_t offset = static_cast<Number*>(*accesses[i].M)->value;
+        if (offset % 8 != 0) aligned = false;
+        auto inserted = slot_of_offset.insert({offset, offsets.size()});
+        if (inserted.second) offsets.push_back(offset);
+        slot_at[i] = inserted.first->second;
+      }
+      int64_t slots = offsets.size();
+      if (slots == 0) {
+        fptr->locals = 0;
+        return;
+      }
+      if (!aligned) {
+        /*
+        Not something the spiller writes, leave the offsets alone and just make the frame big enough.
+        */
+        fptr->locals = slot_of_offset.rbegin()->first / 8 + 1;
+        return;
+      }
+
+      /*
+      Slot liveness, iterated to a fixed point over the instruction CFG.
+      */
+      fptr->calculateCFG();
+      const InstructionTables &tables = fptr->tables;
+
+      std::vector<BitVector> in(n, BitVector(slots));
+      std::vector<BitVector> out(n, BitVector(slots));
+      std::vector<int64_t> worklist;
+      std::vector<bool> queued(n, true);
+      for (int64_t i = 0; i < n; i++) {
+        worklist.push_back(i);
+      }
+      BitVector empty(slots);
+      BitVector single(slots);
+      while (!worklist.empty()) {
+        int64_t i = worklist.back();
+        worklist.pop_back();
+        queued[i] = false;
+
+        for (auto s : tables.successors(i)) {
+          out[i].union_with(in[s]);
+        }
+        const BitVector *gen = &empty;
+        const BitVector *kill = &empty;
+        single.clear();
+        if (slot_at[i] != -1) {
+          single.set(slot_at[i]);
+          if (accesses[i].use) gen = &single;
+          else kill = &single;
+        }
+        if (in[i].assign_transfer(*gen, out[i], *kill)) {
+          for (auto p : tables.predecessors(i)) {
+            if (!queued[p]) {
+              queued[p] = true;
+              worklist.push_back(p);
+            }
+          }
+        }
+      }
+
+      /*
+      Interference: a stored slot conflicts with every other slot live after the store, and the slots live on entry
+      (read before any store) all conflict with each other.
+      */
+      std::vector<BitVector> interferes(slots, BitVector(slots));
+      auto add_edge = [&](int64_t a, int64_t b) {
+        if (a == b) return;
+        interferes[a].set(b);
+        interferes[b].set(a);
+      };
+      for (int64_t i = 0; i < n; i++) {
+        if (slot_at[i] == -1 || !accesses[i].def) continue;
+        out[i].for_each([&](size_t other) { add_edge(slot_at[i], other); });
+      }
+      std::vector<int64_t> live_on_entry;
+      in[0].for_each([&](size_t slot) { live_on_entry.push_back(slot); });
+      for (auto a : live_on_entry) {
+        for (auto b : live_on_entry) add_edge(a, b);
+      }
+
+      /*
+      Greedy coloring in order of first appearance, there is no limit on the number of colors.
+      */
+      std::vector<int64_t> color(slots, -1);
+      int64_t colors = 0;
+      for (int64_t slot = 0; slot < slots; slot++) {
+        std::vector<bool> taken(colors + 1, false);
+        interferes[slot].for_each([&](size_t other) {
+          if (color[other] != -1) taken[color[other]] = true;
+        });
+        int64_t c = 0;
+        while (taken[c]) c++;
+        color[slot] = c;
+        if (c == colors) colors++;
+      }
+      if (debug) std::cerr << fptr->name << ": " << slots << " stack slots share " << colors << " locals" << std::endl;
+
+      for (int64_t i = 0; i < n; i++) {
+        if (slot_at[i] == -1) continue;
+        *accesses[i].M = new Number(color[slot_at[i]] * 8);
+      }
+      fptr->locals = colors;
+    }
+
+}
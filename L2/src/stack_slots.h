@@ -0,0 +1,16 @@
+#pragma once
+
+#include "L2.h"
+
+namespace L2 {
+
+    /*
+    Stack slot allocation for spilled values, run once register allocation is done.
+    - every "mem rsp N" with N >= 0 is a slot; a slot is live from a store to the loads that can read it, the same
+      backward dataflow as variable liveness with stores as defs and loads as uses.
+    - slots that are never live at the same time get the same color, and every offset is rewritten to color * 8.
+    - Function::locals ends up as the number of colors, which is what the code generator emits as the frame size.
+    */
+    void allocate_stack_slots(Function *fptr);
+
+}
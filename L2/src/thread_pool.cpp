@@ -0,0 +1,69 @@
+#include <thread>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace L2 {
+
+    WorkStealingPool::WorkStealingPool(int64_t threads) : threads(threads < 1 ? 1 : threads) {}
+
+    void WorkStealingPool::run(const std::vector<std::function<void()>> &jobs) {
+      size_t workers = std::min<size_t>(threads, jobs.size());
+      if (workers == 0) return;
+      queues = std::vector<WorkQueue>(workers);
+      error = nullptr;
+      for (size_t job = 0; job < jobs.size(); job++) {
+        queues[job % workers].jobs.push_back(job);
+      }
+
+      /*
+      The calling thread is worker 0.
+      */
+      std::vector<std::thread> pool;
+      for (size_t worker = 1; worker < workers; worker++) {
+        pool.emplace_back(&WorkStealingPool::work, this, worker, std::cref(jobs));
+      }
+      work(0, jobs);
+      for (auto& thread : pool) thread.join();
+
+      if (error) std::rethrow_exception(error);
+    }
+
+    bool WorkStealingPool::take(size_t worker, size_t &job) {
+      {
+        std::lock_guard<std::mutex> guard(queues[worker].lock);
+        if (!queues[worker].jobs.empty()) {
+          job = queues[worker].jobs.front();
+          queues[worker].jobs.pop_front();
+          return true;
+        }
+      }
+      for (size_t k = 1; k < queues.size(); k++) {
+        WorkQueue &victim = queues[(worker + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+          job = victim.jobs.back();
+          victim.jobs.pop_back();
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /*
+    No job is ever added once the run started, so a worker that finds every deque empty is done.
+    */
+    void WorkStealingPool::work(size_t worker, const std::vector<std::function<void()>> &jobs) {
+      size_t job;
+      while (take(worker, job)) {
+        try {
+          jobs[job]();
+        } catch (...) {
+          std::lock_guard<std::mutex> guard(error_lock);
+          if (!error) error = std::current_exception();
+        }
+      }
+    }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace L2 {
+
+    /*
+    Work-stealing pool for independent jobs known up front (one register allocation per function).
+    - jobs are dealt round robin, in the order given, onto one deque per worker: pass them biggest first and every
+      worker starts on one of the biggest jobs.
+    - a worker takes jobs from the front of its own deque; once that is empty it steals from the back of the
+      others, where the smallest jobs are, so the tail of the run is balanced with cheap jobs.
+    - run returns once every job has finished. The first exception thrown by a job is rethrown there.
+    */
+    class WorkStealingPool {
+        public:
+            WorkStealingPool(int64_t threads);
+            void run(const std::vector<std::function<void()>> &jobs);
+
+        private:
+            struct WorkQueue {
+                std::mutex lock;
+                std::deque<size_t> jobs;
+            };
+
+            bool take(size_t worker, size_t &job);
+            void work(size_t worker, const std::vector<std::function<void()>> &jobs);
+
+            int64_t threads;
+            std::vector<WorkQueue> queues;
+            std::mutex error_lock;
+            std::exception_ptr error;
+    };
+
+}
@@ -2,12 +2,14 @@
 
 # Fetch the inputs
 if test $# -lt 3 ; then
-  echo "USAGE: `basename $0` EXTENSION_FILE COMPILER TESTS_DIR" ;
+  echo "USAGE: `basename $0` EXTENSION_FILE COMPILER TESTS_DIR [COMPILER_ARGUMENTS]" ;
   exit 1;
 fi
 extFile=$1 ;
 compiler=$2 ;
 testsDir=$3 ;
+shift 3 ;
+compilerArgs="$@" ;
 
 # Define the variables
 origDir=`pwd` ;
@@ -45,7 +47,7 @@ for i in `ls -S -r *.${extFile}` ; do
   pushd ./ &> /dev/null ;
   cd "${origDir}" ;
   didSucceed=0 ;
-  ./${compiler} ${testsDir}/${i} &> /dev/null;
+  ./${compiler} ${compilerArgs} ${testsDir}/${i} &> /dev/null;
   if test $? -eq 0 ; then
     if test -f ${testsDir}/${i}.in ; then
       (./a.out || false) < ${testsDir}/${i}.in > ${testsDir}/${i}.out.tmp 2>&1;